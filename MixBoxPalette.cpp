@@ -8,13 +8,22 @@ std::optional<int> previousX;
 
 std::optional<int> previousY;
 
-const int virtualCanvasWidth = 256;
+// Brush strokes land on a virtual grid a quarter of the display canvas resolution
+const int virtualCanvasScale = 4;
 
-const int virtualCanvasHeight = 256;
+int displayCanvasWidth = 1024;
 
-const int displayCanvasWidth = 1024;
+int displayCanvasHeight = 1024;
 
-const int displayCanvasHeight = 1024;
+int virtualCanvasWidth = displayCanvasWidth / virtualCanvasScale;
+
+int virtualCanvasHeight = displayCanvasHeight / virtualCanvasScale;
+
+// Upper bound on presents per second for the palette and the color picker, nothing is drawn while idle
+int maxFramesPerSecond = 60;
+
+// An idle loop still wakes this often, without drawing anything
+const int idleWakeMilliseconds = 1000;
 
 float zoom = 1;
 
@@ -41,7 +50,8 @@ void handleMouseButtonDown(const std::unique_ptr<SDL_Renderer, decltype(&SDL_Des
                            const Toolbar &brushToolbar,
                            const SDL_Event &e,
                            ColorPicker &colorPicker,
-                           Canvas &canvas);
+                           Canvas &canvas,
+                           StrokeWorker &strokeWorker);
 
 void handleMouseMotion(const std::unique_ptr<SDL_Renderer, decltype(&SDL_DestroyRenderer)> &renderer,
                        Tool *colorPickerTool,
@@ -49,9 +59,19 @@ void handleMouseMotion(const std::unique_ptr<SDL_Renderer, decltype(&SDL_Destroy
                        const Toolbar &brushSizeToolbar,
                        SDL_Event &e,
                        ColorPicker &colorPicker,
-                       Canvas &canvas);
+                       Canvas &canvas,
+                       StrokeWorker &strokeWorker);
 int main(int argc, char *argv[])
 {
+    // MixBoxPalette [canvasWidth canvasHeight [maxFramesPerSecond]], blank areas of the canvas take no memory
+    if (argc >= 3) {
+        displayCanvasWidth = std::max(std::atoi(argv[1]), virtualCanvasScale);
+        displayCanvasHeight = std::max(std::atoi(argv[2]), virtualCanvasScale);
+        virtualCanvasWidth = displayCanvasWidth / virtualCanvasScale;
+        virtualCanvasHeight = displayCanvasHeight / virtualCanvasScale;
+    }
+    if (argc >= 4) { maxFramesPerSecond = std::clamp(std::atoi(argv[3]), 1, 1000); }
+
     sdlInit();
     auto window = sdlSetupWindow();
     auto renderer = sdlSetupRenderer(window.get());
@@ -59,6 +79,7 @@ int main(int argc, char *argv[])
         font(TTF_OpenFont("assets/Roboto-Regular.ttf", 28), TTF_CloseFont);
 
     ColorPicker colorPicker(window.get(), font.get());
+    colorPicker.maxFramesPerSecond = maxFramesPerSecond;
     Canvas canvas(renderer.get(),
                   virtualCanvasWidth,
                   virtualCanvasHeight,
@@ -66,6 +87,7 @@ int main(int argc, char *argv[])
                   displayCanvasHeight,
                   windowWidth,
                   windowHeight);
+    StrokeWorker strokeWorker(canvas);
 
     auto paintTool = new Tool(ToolType::Paint, "assets/paintIcon.png", renderer.get());
     auto blendTool = new Tool(ToolType::Blend, "assets/blendIcon.png", renderer.get());
@@ -91,22 +113,39 @@ int main(int argc, char *argv[])
     toolbars.push_back(&brushSizeToolbar);
 
     bool quit = false;
+    bool redraw = true;
+    Uint32 lastPresent = 0;
     SDL_Event e;
 
     while (!quit) {
-        while (SDL_PollEvent(&e) != 0) {
+        // Sleep until input arrives or the stroke worker finishes painting; with a frame pending
+        // only until it is due
+        Uint32 frameMilliseconds = 1000 / maxFramesPerSecond;
+        Uint32 sincePresent = SDL_GetTicks() - lastPresent;
+        bool framePending = redraw || canvas.hasDamage() || strokeWorker.hasUnflushedPaint();
+        int timeout = !framePending ? idleWakeMilliseconds
+                                    : static_cast<int>(frameMilliseconds - std::min(sincePresent, frameMilliseconds));
+
+        bool hasEvent = SDL_WaitEventTimeout(&e, timeout) != 0;
+        while (hasEvent) {
             switch (e.type) {
                 case SDL_QUIT:
                     quit = true;
                     break;
 
+                case SDL_WINDOWEVENT:
+                    redraw = true;
+                    break;
+
                 case SDL_MOUSEWHEEL:
                     handleMouseWheelEvent(e, zoom, canvas);
+                    redraw = true;
                     break;
 
                 case SDL_MOUSEBUTTONDOWN:
                     isMouseButtonDown = true;
-                    handleMouseButtonDown(renderer, colorPickerTool, brushToolbar, e, colorPicker, canvas);
+                    handleMouseButtonDown(renderer, colorPickerTool, brushToolbar, e, colorPicker, canvas, strokeWorker);
+                    redraw = true;
                     break;
 
                 case SDL_MOUSEBUTTONUP:
@@ -114,8 +153,7 @@ int main(int argc, char *argv[])
                     isPanning = false;
                     previousX.reset();
                     previousY.reset();
-                    canvas.firstBlendColor.reset();
-                    canvas.secondBlendColor.reset();
+                    strokeWorker.endStroke(e.button.timestamp);
                     break;
 
                 case SDL_MOUSEMOTION:
@@ -125,15 +163,28 @@ int main(int argc, char *argv[])
                                       brushSizeToolbar,
                                       e,
                                       colorPicker,
-                                      canvas);
+                                      canvas,
+                                      strokeWorker);
+                    // Painting shows up as canvas damage, panning and eyedropping change the view
+                    redraw = redraw || isPanning || (isMouseButtonDown && brushToolbar.currentTool == ToolType::EyeDropper);
                     break;
             }
+            hasEvent = SDL_PollEvent(&e) != 0;
         }
 
+        if (SDL_GetTicks() - lastPresent < frameMilliseconds) continue;
+
+        // Motion from this frame is painted as one polyline
+        strokeWorker.flush(SDL_GetTicks());
+        if (!redraw && !canvas.hasDamage()) continue;
+
+        canvas.updateTexture();
         SDL_RenderClear(renderer.get());
-        SDL_RenderCopy(renderer.get(), canvas.texture.get(), &canvas.srcRect, nullptr);
+        canvas.render();
         drawUI(renderer.get());
         SDL_RenderPresent(renderer.get());
+        redraw = false;
+        lastPresent = SDL_GetTicks();
     }
 
     return 0;
@@ -156,7 +207,8 @@ void handleMouseMotion(const std::unique_ptr<SDL_Renderer, decltype(&SDL_Destroy
                        const Toolbar &brushSizeToolbar,
                        SDL_Event &e,
                        ColorPicker &colorPicker,
-                       Canvas &canvas)
+                       Canvas &canvas,
+                       StrokeWorker &strokeWorker)
 {
     SDL_SetCursor(SDL_CreateSystemCursor(
         brushToolbar.currentTool == ToolType::EyeDropper && e.button.y < windowHeight - 50 ? SDL_SYSTEM_CURSOR_CROSSHAIR
@@ -178,17 +230,20 @@ void handleMouseMotion(const std::unique_ptr<SDL_Renderer, decltype(&SDL_Destroy
         uint32_t color = (static_cast<uint32_t>(rgbColor.r * 255) << 24) |
             (static_cast<uint32_t>(rgbColor.g * 255) << 16) |
             (static_cast<uint32_t>(rgbColor.b * 255) << 8) | 255;
-        int currentX = e.motion.x / (windowWidth / virtualCanvasWidth);
-        int currentY = e.motion.y / (windowHeight / virtualCanvasHeight);
+        int currentX = e.motion.x * virtualCanvasWidth / windowWidth;
+        int currentY = e.motion.y * virtualCanvasHeight / windowHeight;
         if (previousX.has_value() && previousY.has_value()) {
-            canvas.setPixel(currentX,
-                            currentY,
-                            previousX.value(),
-                            previousY.value(),
-                            color,
-                            static_cast<int>(brushToolbar.currentTool),
-                            static_cast<int>(brushSizeToolbar.currentTool));
-            canvas.rebuildHighResPixels(renderer.get());
+            // Zoom and pan belong to this thread, so samples are mapped onto the canvas before queueing
+            auto [x1, y1] = canvas.toCanvasCoordinates(currentX, currentY);
+            auto [x2, y2] = canvas.toCanvasCoordinates(previousX.value(), previousY.value());
+            strokeWorker.paint(e.motion.timestamp,
+                               x1,
+                               y1,
+                               x2,
+                               y2,
+                               color,
+                               static_cast<int>(brushToolbar.currentTool),
+                               static_cast<int>(brushSizeToolbar.currentTool));
         }
         previousX = currentX;
         previousY = currentY;
@@ -199,7 +254,8 @@ void handleMouseButtonDown(const std::unique_ptr<SDL_Renderer, decltype(&SDL_Des
                            const Toolbar &brushToolbar,
                            const SDL_Event &e,
                            ColorPicker &colorPicker,
-                           Canvas &canvas)
+                           Canvas &canvas,
+                           StrokeWorker &strokeWorker)
 {
     if (e.button.button == SDL_BUTTON_LEFT) {
         for (auto t: toolbars) {
@@ -212,7 +268,7 @@ void handleMouseButtonDown(const std::unique_ptr<SDL_Renderer, decltype(&SDL_Des
                         ->setColor(from_RGBColor(hsv_to_rgb(colorPicker.currentColor)), renderer.get());
                 }
                 if (t->currentTool == ToolType::ResetCanvas) {
-                    canvas.resetCanvas(renderer.get());
+                    strokeWorker.resetCanvas(e.button.timestamp);
                 }
             }
         }
@@ -9,4 +9,5 @@
 #include "toolbar/Toolbar.h"
 #include "colorPicker/ColorPicker.h"
 #include "canvas/Canvas.h"
+#include "canvas/StrokeWorker.h"
 #include <algorithm>
@@ -0,0 +1,27 @@
+#ifndef BLEND_SAMPLER_H
+#define BLEND_SAMPLER_H
+
+#include "ColorHistogram.h"
+
+// Color counts of the brush disc at the last blend sample of a stroke. The Canvas slides the
+// disc as the brush moves and updates the counts when strokes paint over it, so a sample
+// only reads the pixels the brush entered or left since the previous one
+class BlendSampler {
+public:
+    BlendSampler() : active(false), centerX(0), centerY(0), radius(0) {}
+
+    void reset()
+    {
+        active = false;
+        histogram.clear();
+    }
+
+private:
+    friend class Canvas;
+
+    bool active;
+    int centerX, centerY, radius;
+    ColorHistogram histogram;
+};
+
+#endif // BLEND_SAMPLER_H
@@ -10,25 +10,105 @@ Canvas::Canvas(SDL_Renderer *renderer,
     : virtualCanvasWidth(width), virtualCanvasHeight(height),
       displayCanvasWidth(displayCanvasWidth), displayCanvasHeight(displayCanvasHeight),
       windowWidth(windowWidth), windowHeight(windowHeight),
-      pixels(),
-      texture(SDL_CreateTexture(renderer,
-                                SDL_PIXELFORMAT_RGBA8888,
-                                SDL_TEXTUREACCESS_TARGET,
-                                displayCanvasWidth,
-                                displayCanvasHeight), SDL_DestroyTexture),
-      srcRect{0, 0, displayCanvasWidth, displayCanvasHeight},
+      renderer(renderer),
+      srcRect{0, 0, displayCanvasWidth, displayCanvasHeight}, brushSpacing(0.25f), smoothStrokes(false),
+      tilesX((displayCanvasWidth + tileSize - 1) / tileSize), tilesY((displayCanvasHeight + tileSize - 1) / tileSize),
+      tiles(tilesX * tilesY), dirtyTiles(tilesX * tilesY), damaged(false), tileMutexes(tilesX * tilesY),
       originalWidth(displayCanvasWidth), originalHeight(displayCanvasHeight),
-      format(SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888), SDL_FreeFormat)
+      strokeStarted(false), strokeCarriedDistance(0),
+      drawOrder(4096), tileWorkSlot(tilesX * tilesY, -1), activeTileWork(0),
+      workerPool(std::max(std::thread::hardware_concurrency(), 1u) - 1),
+      latentCache(mixbox_latent_cache_create(8), mixbox_latent_cache_destroy)
 {
-    resetCanvas(renderer);
+    for (int i = 0; i < tilesX * tilesY; ++i) { tileTextures.emplace_back(nullptr, SDL_DestroyTexture); }
+    resetCanvas();
 }
 
-void Canvas::resetCanvas(SDL_Renderer *renderer)
+void Canvas::resetCanvas()
 {
-    SDL_SetRenderTarget(renderer, texture.get()), SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
-    SDL_SetRenderTarget(renderer, nullptr);
-    pixels.assign(displayCanvasWidth * displayCanvasHeight, 0xFFFFFF00);
+    // Only the pixel storage goes, updateTexture releases the textures of the blank tiles
+    for (int tileIndex = 0; tileIndex < tilesX * tilesY; ++tileIndex) {
+        {
+            std::lock_guard<std::mutex> lock(tileMutexes[tileIndex]);
+            tiles[tileIndex].reset();
+        }
+        markTileDamaged(tileIndex);
+    }
+    blendSampler.reset();
+}
+
+Canvas::Tile::Tile() : pixels(tileSize * tileSize, blankPixel) {}
+
+void Canvas::countColors(const uint32_t *pixels, int count, ColorHistogram &histogram, int sign)
+{
+    // Painted areas are long runs of one color, so each run costs one histogram update
+    for (int i = 0; i < count;) {
+        int run = ColorHistogram::runLength(pixels + i, count - i);
+        if (isSampledColor(pixels[i])) { histogram.add(pixels[i], sign * run); }
+        i += run;
+    }
+}
+
+void Canvas::countDiscColors(int centerX, int centerY, int radius, ColorHistogram &histogram) const
+{
+    if (radius < 0) return;
+
+    // Tiles the disc covers completely contribute their whole histogram; the farthest pixel
+    // of a tile from the center is one of its corners
+    auto coversTile = [centerX, centerY, radius, this](int tileIndex)
+    {
+        int left = (tileIndex % tilesX) * tileSize - centerX, top = (tileIndex / tilesX) * tileSize - centerY;
+        int farX = std::max(std::abs(left), std::abs(left + tileSize - 1));
+        int farY = std::max(std::abs(top), std::abs(top + tileSize - 1));
+        return farX * farX + farY * farY <= radius * radius;
+    };
+
+    int firstTileX = std::max(centerX - radius, 0) / tileSize;
+    int lastTileX = std::min(centerX + radius, displayCanvasWidth - 1) / tileSize;
+    int firstTileY = std::max(centerY - radius, 0) / tileSize;
+    int lastTileY = std::min(centerY + radius, displayCanvasHeight - 1) / tileSize;
+    for (int tileY = firstTileY; tileY <= lastTileY; ++tileY) {
+        for (int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+            const Tile *tile = tiles[tileY * tilesX + tileX].get();
+            if (tile && coversTile(tileY * tilesX + tileX)) { histogram.merge(tile->histogram); }
+        }
+    }
+
+    // Only tiles on the edge of the disc are scanned; unallocated tiles are blank, which is never counted
+    forEachStampSegment(centerX, centerY, radius, [this, &histogram, &coversTile](int tileIndex, int row, int column, int count)
+    {
+        const Tile *tile = tiles[tileIndex].get();
+        if (!tile || coversTile(tileIndex)) return;
+        countColors(&tile->pixels[row * tileSize + column], count, histogram, 1);
+    });
+}
+
+const std::vector<int> &Canvas::stampSpans(int radius) const
+{
+    auto cached = stampSpanCache.find(radius);
+    if (cached != stampSpanCache.end()) { return cached->second; }
+
+    // Half width of each row of the disc dx * dx + dy * dy <= radius * radius, top to bottom
+    std::vector<int> halfWidths;
+    for (int dy = -radius; dy <= radius; ++dy) {
+        int halfWidth = static_cast<int>(std::sqrt(static_cast<double>(radius * radius - dy * dy)));
+        while (halfWidth * halfWidth + dy * dy > radius * radius) { --halfWidth; }
+        while ((halfWidth + 1) * (halfWidth + 1) + dy * dy <= radius * radius) { ++halfWidth; }
+        halfWidths.push_back(halfWidth);
+    }
+    return stampSpanCache.emplace(radius, std::move(halfWidths)).first->second;
+}
+
+uint32_t Canvas::pixelAt(int x, int y) const
+{
+    const auto &tile = tiles[(y / tileSize) * tilesX + x / tileSize];
+    return tile ? tile->pixels[(y % tileSize) * tileSize + x % tileSize] : blankPixel;
+}
+
+void Canvas::markTileDamaged(int tileIndex)
+{
+    dirtyTiles[tileIndex] = 1;
+    damaged = true;
 }
 
 void Canvas::setTextureZoom(float zoom, int mouseX, int mouseY)
@@ -55,44 +135,94 @@ void Canvas::setTextureOffset(int deltaX, int deltaY)
     srcRect.y = std::clamp(srcRect.y + static_cast<int>(deltaY * scale), 0, originalHeight - srcRect.h);
 }
 
-void Canvas::setPixel(int x1, int y1, int x2, int y2, uint32_t color, int blend, int brushSize)
+void Canvas::endStroke()
+{
+    firstBlendColor.reset();
+    secondBlendColor.reset();
+    blendSampler.reset();
+    strokeStarted = false;
+    strokeCarriedDistance = 0;
+    strokeBeforeSegment.reset();
+}
+
+void Canvas::queueStamp(StrokePoint center, uint32_t color, int radius)
+{
+    int centerX = static_cast<int>(std::lround(center.x));
+    int centerY = static_cast<int>(std::lround(center.y));
+    // Stamps off the canvas can still reach into it, only discs that miss it entirely are dropped
+    if (centerX + radius >= 0 && centerX - radius < displayCanvasWidth && centerY + radius >= 0
+        && centerY - radius < displayCanvasHeight) {
+        drawOrder.emplace(centerX, centerY, color, radius);
+    }
+}
+
+void Canvas::stampAlong(StrokePoint from, StrokePoint to, uint32_t color, int radius)
+{
+    // Stamps sit brushSpacing * radius apart along the whole stroke, the distance walked since
+    // the last stamp carries over into the next piece
+    float spacing = std::max(brushSpacing * radius, 1.0f);
+    float length = std::hypot(to.x - from.x, to.y - from.y);
+    float distance = spacing - strokeCarriedDistance;
+    for (; distance <= length; distance += spacing) {
+        float t = distance / length;
+        queueStamp({from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t}, color, radius);
+    }
+    strokeCarriedDistance = length - (distance - spacing);
+}
+
+std::pair<int, int> Canvas::toCanvasCoordinates(int x, int y) const
 {
     float zoomFactorX = static_cast<float>(displayCanvasWidth) / srcRect.w;
     float zoomFactorY = static_cast<float>(displayCanvasHeight) / srcRect.h;
     float scaleX = static_cast<float>(displayCanvasWidth) / virtualCanvasWidth;
     float scaleY = static_cast<float>(displayCanvasHeight) / virtualCanvasHeight;
 
-    auto scaleCoord = [zoomFactorX, zoomFactorY, scaleX, scaleY, &rect = srcRect](int x, int y)
-    {
-        return std::make_pair(
-            static_cast<int>((x / zoomFactorX) + (rect.x / scaleX)),
-            static_cast<int>((y / zoomFactorY) + (rect.y / scaleY))
-        );
-    };
-
-    std::tie(x1, y1) = scaleCoord(x1, y1);
-    std::tie(x2, y2) = scaleCoord(x2, y2);
+    return std::make_pair(
+        static_cast<int>((x / zoomFactorX) + (srcRect.x / scaleX)),
+        static_cast<int>((y / zoomFactorY) + (srcRect.y / scaleY))
+    );
+}
 
+void Canvas::setPixel(int x1, int y1, int x2, int y2, uint32_t color, int blend, int brushSize)
+{
     int radius = (brushSize - 3) * 15;
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    int steps = std::max(abs(dx), abs(dy));
-    float xInc = dx / static_cast<float>(steps);
-    float yInc = dy / static_cast<float>(steps);
     float x = x1;
     float y = y1;
 
-    auto drawPixels = [this, &x, &y, steps, xInc, yInc, radius](uint32_t drawColor)
+    // The segment runs from the previous sample (x2, y2) to the current one (x1, y1)
+    auto drawPixels = [this, x1, y1, x2, y2, radius](uint32_t drawColor)
     {
-        for (int i = 0; i <= steps; i++) {
-            int roundX = round(x);
-            int roundY = round(y);
-            if (roundX >= 0 && roundX < displayCanvasWidth && roundY >= 0 && roundY < displayCanvasHeight) {
-                drawOrder.emplace(roundX, roundY, drawColor, radius);
+        float scaleX = static_cast<float>(displayCanvasWidth) / virtualCanvasWidth;
+        float scaleY = static_cast<float>(displayCanvasHeight) / virtualCanvasHeight;
+        StrokePoint from{x2 * scaleX, y2 * scaleY}, to{x1 * scaleX, y1 * scaleY};
+        if (!strokeStarted) {
+            queueStamp(from, drawColor, radius);
+            strokeStarted = true;
+            strokeCarriedDistance = 0;
+        }
+
+        if (!smoothStrokes) {
+            stampAlong(from, to, drawColor, radius);
+        } else {
+            // Catmull-Rom through the point before the segment, with the end tangent extrapolated
+            // from the segment itself, walked as short chords
+            StrokePoint before = strokeBeforeSegment.value_or(from);
+            StrokePoint after{2 * to.x - from.x, 2 * to.y - from.y};
+            int chords = std::clamp(static_cast<int>(std::hypot(to.x - from.x, to.y - from.y) / 2), 1, 64);
+            StrokePoint chordStart = from;
+            for (int i = 1; i <= chords; ++i) {
+                float t = static_cast<float>(i) / chords, t2 = t * t, t3 = t2 * t;
+                auto curve = [t, t2, t3](float p0, float p1, float p2, float p3)
+                {
+                    return 0.5f * (2 * p1 + (p2 - p0) * t + (2 * p0 - 5 * p1 + 4 * p2 - p3) * t2
+                        + (3 * p1 - p0 - 3 * p2 + p3) * t3);
+                };
+                StrokePoint chordEnd{curve(before.x, from.x, to.x, after.x), curve(before.y, from.y, to.y, after.y)};
+                stampAlong(chordStart, chordEnd, drawColor, radius);
+                chordStart = chordEnd;
             }
-            x += xInc;
-            y += yInc;
         }
+        strokeBeforeSegment = from;
     };
 
     if (!blend) {
@@ -101,12 +231,12 @@ void Canvas::setPixel(int x1, int y1, int x2, int y2, uint32_t color, int blend,
     }
 
     if (!firstBlendColor) {
-        auto [mostCommonColor, frequency] = getMostCommonColorInRadius(x, y, radius, 0x00000000);
+        auto [mostCommonColor, frequency] = sampleBlendColor(x, y, radius, 0x00000000);
         if (frequency == 0) return;
         firstBlendColor = mostCommonColor;
     }
 
-    auto [mostCommonColor, frequency] = getMostCommonColorInRadius(x, y, radius, firstBlendColor.value());
+    auto [mostCommonColor, frequency] = sampleBlendColor(x, y, radius, firstBlendColor.value());
     if (frequency != 0) { secondBlendColor = mostCommonColor; }
     if (secondBlendColor) { firstBlendColor = blendColors(radius, frequency); }
 
@@ -124,41 +254,187 @@ uint32_t Canvas::blendColors(int radius, int frequency)
     Uint8 b2 = (secondBlendColor.value() >> 8) & 0xFF;
 
     float mixingRatio = std::clamp(static_cast<float>(frequency) / (radius * radius * M_PI), 0.0, 1.0);
-    mixbox_lerp(r1, g1, b1, r2, g2, b2, mixingRatio, &r2, &g2, &b2);
+    mixbox_cached_lerp(latentCache.get(), r1, g1, b1, r2, g2, b2, mixingRatio, &r2, &g2, &b2);
     return (r2 << 24) | (g2 << 16) | (b2 << 8) | 255;
 }
 
-void Canvas::rebuildHighResPixels(SDL_Renderer *renderer)
+void Canvas::rebuildHighResPixels()
 {
-    int scaleFactorX = displayCanvasWidth / virtualCanvasWidth;
-    int scaleFactorY = displayCanvasHeight / virtualCanvasHeight;
-    SDL_SetRenderTarget(renderer, texture.get());
+    // Stamps and spans are private to the painting thread, tiles are locked one at a time in paintTileWork
     while (!drawOrder.empty()) {
-        PixelInfo pixelInfo = drawOrder.front();
-        drawOrder.pop();
-        Uint8 r1, g1, b1, a1;
-        SDL_GetRGBA(pixelInfo.color, format.get(), &r1, &g1, &b1, &a1);
-        SDL_SetRenderDrawColor(renderer, r1, g1, b1, a1);
-        int centerX = pixelInfo.x * scaleFactorX;
-        int centerY = pixelInfo.y * scaleFactorY;
-        int radius = pixelInfo.radius;
-
-        for (int dy = -radius; dy <= radius; ++dy) {
-            for (int dx = -radius; dx <= radius; ++dx) {
-                if (dx * dx + dy * dy <= radius * radius) {
-                    int highResX = centerX + dx;
-                    int highResY = centerY + dy;
-                    if (highResX >= 0 && highResX < displayCanvasWidth && highResY >= 0
-                        && highResY < displayCanvasHeight) {
-                        int highResIndex = highResY * displayCanvasWidth + highResX;
-                        SDL_RenderDrawPoint(renderer, highResX, highResY);
-                        pixels[highResIndex] = pixelInfo.color;
-                    }
-                }
+        // Consecutive stamps of one color can be painted in any order, so their row runs are
+        // merged and every covered pixel is written once instead of once per overlapping stamp
+        uint32_t color = drawOrder.front().color;
+        std::optional<PixelInfo> previous;
+        coalescedSpans.clear();
+        while (!drawOrder.empty() && drawOrder.front().color == color) {
+            PixelInfo pixelInfo = drawOrder.front();
+            drawOrder.pop();
+            int centerX = pixelInfo.x;
+            int centerY = pixelInfo.y;
+            int radius = pixelInfo.radius;
+
+            // A disc inside the previous one adds no pixels
+            if (previous) {
+                int offsetX = centerX - previous->x, offsetY = centerY - previous->y;
+                int slack = previous->radius - radius;
+                if (slack >= 0 && offsetX * offsetX + offsetY * offsetY <= slack * slack) continue;
+            }
+            previous.emplace(centerX, centerY, color, radius);
+
+            forEachStampRow(centerX, centerY, radius, [this](int y, int x, int end)
+            {
+                coalescedSpans.push_back({y, x, end});
+            });
+        }
+
+        std::sort(coalescedSpans.begin(), coalescedSpans.end(), [](const Span &a, const Span &b)
+        {
+            return a.y != b.y ? a.y < b.y : a.x < b.x;
+        });
+
+        for (size_t i = 0; i < coalescedSpans.size();) {
+            Span merged = coalescedSpans[i++];
+            while (i < coalescedSpans.size() && coalescedSpans[i].y == merged.y && coalescedSpans[i].x <= merged.end) {
+                merged.end = std::max(merged.end, coalescedSpans[i++].end);
+            }
+
+            // Part of the run under a live blend sample, which has to follow the pixels painted under it
+            int sampledX = 0, sampledEnd = 0;
+            if (blendSampler.active) {
+                stampRowExtent(blendSampler.centerX, blendSampler.centerY, blendSampler.radius, merged.y, sampledX, sampledEnd);
+            }
+            forEachRowSegment(merged.y, merged.x, merged.end,
+                              [this, color, sampledX, sampledEnd](int tileIndex, int row, int column, int count)
+            {
+                int x = (tileIndex % tilesX) * tileSize + column;
+                int sampledColumn = std::max(sampledX, x) - x;
+                int sampledCount = std::max(std::min(sampledEnd, x + count) - std::max(sampledX, x), 0);
+                queueTileSegment(tileIndex, {row, column, count, color, sampledColumn, sampledCount});
+            });
+        }
+    }
+
+    // Tiles are independent, and each applies its segments in queue order, so painting them
+    // in parallel gives the same pixels as painting the queue serially
+    size_t pixelCount = 0;
+    for (size_t i = 0; i < activeTileWork; ++i) {
+        for (const TileSegment &segment: tileWork[i].segments) { pixelCount += segment.count; }
+    }
+    auto paint = [this](size_t workIndex) { paintTileWork(tileWork[workIndex]); };
+    if (pixelCount >= parallelPaintThreshold) {
+        workerPool.parallelFor(activeTileWork, paint);
+    } else {
+        for (size_t i = 0; i < activeTileWork; ++i) { paint(i); }
+    }
+
+    // Sampler changes are merged in tile order so the histogram does not depend on scheduling
+    for (size_t i = 0; i < activeTileWork; ++i) {
+        TileWork &work = tileWork[i];
+        if (blendSampler.active) { blendSampler.histogram.merge(work.samplerDelta); }
+        tileWorkSlot[work.tileIndex] = -1;
+        work.segments.clear();
+        work.samplerDelta.clear();
+    }
+    activeTileWork = 0;
+}
+
+void Canvas::queueTileSegment(int tileIndex, const TileSegment &segment)
+{
+    int &slot = tileWorkSlot[tileIndex];
+    if (slot < 0) {
+        if (activeTileWork == tileWork.size()) { tileWork.emplace_back(); }
+        slot = static_cast<int>(activeTileWork++);
+        tileWork[slot].tileIndex = tileIndex;
+    }
+    tileWork[slot].segments.push_back(segment);
+}
+
+void Canvas::paintTileWork(TileWork &work)
+{
+    {
+        std::lock_guard<std::mutex> lock(tileMutexes[work.tileIndex]);
+        auto &tile = tiles[work.tileIndex];
+        if (!tile) { tile = std::make_unique<Tile>(); }
+        for (const TileSegment &segment: work.segments) {
+            uint32_t *span = &tile->pixels[segment.row * tileSize + segment.column];
+            if (segment.sampledCount > 0) {
+                countColors(span + segment.sampledColumn, segment.sampledCount, work.samplerDelta, -1);
+                if (isSampledColor(segment.color)) { work.samplerDelta.add(segment.color, segment.sampledCount); }
             }
+            countColors(span, segment.count, tile->histogram, -1);
+            if (isSampledColor(segment.color)) { tile->histogram.add(segment.color, segment.count); }
+            std::fill_n(span, segment.count, segment.color);
+        }
+    }
+    // Published once its segments are all written, the render thread can upload it while other tiles paint
+    markTileDamaged(work.tileIndex);
+}
+
+void Canvas::updateTexture()
+{
+    // Flags are cleared before the tile is read, a tile finished meanwhile is uploaded next frame
+    if (!damaged.exchange(false)) return;
+
+    for (int tileIndex = 0; tileIndex < tilesX * tilesY; ++tileIndex) {
+        if (!dirtyTiles[tileIndex].exchange(0)) continue;
+        // Waits for at most the one tile being painted
+        std::lock_guard<std::mutex> lock(tileMutexes[tileIndex]);
+
+        // Blank tiles have no storage and no texture, render() leaves them to the background
+        auto &texture = tileTextures[tileIndex];
+        const Tile *tile = tiles[tileIndex].get();
+        if (!tile) {
+            texture.reset();
+            continue;
+        }
+
+        if (!texture) {
+            texture.reset(SDL_CreateTexture(renderer,
+                                            SDL_PIXELFORMAT_RGBA8888,
+                                            SDL_TEXTUREACCESS_STREAMING,
+                                            tileSize,
+                                            tileSize));
+            // Blank pixels carry a zero alpha, tiles are copied opaque so they show up white
+            SDL_SetTextureBlendMode(texture.get(), SDL_BLENDMODE_NONE);
+        }
+        SDL_UpdateTexture(texture.get(), nullptr, tile->pixels.data(), tileSize * static_cast<int>(sizeof(uint32_t)));
+    }
+}
+
+void Canvas::render()
+{
+    int outputWidth, outputHeight;
+    SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight);
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderFillRect(renderer, nullptr);
+
+    // Tile edges map through the same rounding, so neighbouring tiles meet without gaps
+    auto toOutputX = [&](int x) { return static_cast<int>(static_cast<int64_t>(x - srcRect.x) * outputWidth / srcRect.w); };
+    auto toOutputY = [&](int y) { return static_cast<int>(static_cast<int64_t>(y - srcRect.y) * outputHeight / srcRect.h); };
+
+    SDL_Rect canvasRect{0, 0, displayCanvasWidth, displayCanvasHeight};
+    SDL_Rect visibleRect;
+    if (!SDL_IntersectRect(&srcRect, &canvasRect, &visibleRect)) return;
+
+    // Textures belong to this thread, so drawing never waits for the painter
+    for (int tileY = visibleRect.y / tileSize; tileY <= (visibleRect.y + visibleRect.h - 1) / tileSize; ++tileY) {
+        for (int tileX = visibleRect.x / tileSize; tileX <= (visibleRect.x + visibleRect.w - 1) / tileSize; ++tileX) {
+            SDL_Texture *texture = tileTextures[tileY * tilesX + tileX].get();
+            if (!texture) continue;
+
+            SDL_Rect tileRect{tileX * tileSize, tileY * tileSize, tileSize, tileSize};
+            SDL_Rect visibleTileRect;
+            SDL_IntersectRect(&tileRect, &visibleRect, &visibleTileRect);
+
+            SDL_Rect sourceRect{visibleTileRect.x - tileRect.x, visibleTileRect.y - tileRect.y, visibleTileRect.w, visibleTileRect.h};
+            SDL_Rect destinationRect{toOutputX(visibleTileRect.x), toOutputY(visibleTileRect.y), 0, 0};
+            destinationRect.w = toOutputX(visibleTileRect.x + visibleTileRect.w) - destinationRect.x;
+            destinationRect.h = toOutputY(visibleTileRect.y + visibleTileRect.h) - destinationRect.y;
+            SDL_RenderCopy(renderer, texture, &sourceRect, &destinationRect);
         }
     }
-    SDL_SetRenderTarget(renderer, nullptr);
 }
 
 uint32_t Canvas::getPixel(int x, int y) const
@@ -170,36 +446,60 @@ uint32_t Canvas::getPixel(int x, int y) const
         return 0x00000000;
     }
 
-    return pixels[zoomedY * displayCanvasWidth + zoomedX];
+    std::lock_guard<std::mutex> lock(tileMutexes[(zoomedY / tileSize) * tilesX + zoomedX / tileSize]);
+    return pixelAt(zoomedX, zoomedY);
 }
 
-std::pair<uint32_t, int>
-Canvas::getMostCommonColorInRadius(int centerX, int centerY, int maxRadius, uint32_t excludeColor) const
+std::pair<uint32_t, int> Canvas::sampleBlendColor(int centerX, int centerY, int radius, uint32_t excludeColor)
 {
-    std::unordered_map<Uint32, int> colorFrequency;
-    int displayCanvasCenterX = centerX * displayCanvasWidth / virtualCanvasWidth;
-    int displayCanvasCenterY = centerY * displayCanvasHeight / virtualCanvasHeight;
+    moveBlendSampler(centerX * displayCanvasWidth / virtualCanvasWidth,
+                     centerY * displayCanvasHeight / virtualCanvasHeight, radius);
+    return blendSampler.histogram.mostCommon(excludeColor);
+}
 
-    for (int y = -maxRadius; y <= maxRadius; ++y) {
-        for (int x = -maxRadius; x <= maxRadius; ++x) {
-            if (x * x + y * y <= maxRadius * maxRadius) {
-                int displayCanvasX = displayCanvasCenterX + x, displayCanvasY = displayCanvasCenterY + y;
+void Canvas::moveBlendSampler(int centerX, int centerY, int radius)
+{
+    int offsetX = centerX - blendSampler.centerX, offsetY = centerY - blendSampler.centerY;
 
-                if (displayCanvasX >= 0 && displayCanvasX < displayCanvasWidth && displayCanvasY >= 0
-                    && displayCanvasY < displayCanvasHeight) {
-                    uint32_t color = pixels[displayCanvasY * displayCanvasWidth + displayCanvasX];
-                    if (color != excludeColor && color != 0x00FFFFFF && color != 0x00000000 && color != 0xFFFFFF00) {
-                        colorFrequency[color]++;
-                    }
-                }
-            }
+    // Past a radius of travel the crescents cover about as much as the whole disc
+    if (!blendSampler.active || radius != blendSampler.radius || std::abs(offsetX) > radius || std::abs(offsetY) > radius) {
+        blendSampler.histogram.clear();
+        countDiscColors(centerX, centerY, radius, blendSampler.histogram);
+    } else if (offsetX != 0 || offsetY != 0) {
+        // Per row, remove the part of the old disc the brush left and add the part it entered
+        int firstRow = std::max(std::min(centerY, blendSampler.centerY) - radius, 0);
+        int lastRow = std::min(std::max(centerY, blendSampler.centerY) + radius, displayCanvasHeight - 1);
+        for (int y = firstRow; y <= lastRow; ++y) {
+            int oldX = 0, oldEnd = 0, newX = 0, newEnd = 0;
+            stampRowExtent(blendSampler.centerX, blendSampler.centerY, radius, y, oldX, oldEnd);
+            stampRowExtent(centerX, centerY, radius, y, newX, newEnd);
+            countBlendSamplesOutside(y, oldX, oldEnd, newX, newEnd, -1);
+            countBlendSamplesOutside(y, newX, newEnd, oldX, oldEnd, 1);
         }
     }
 
-    auto mostCommonColor = std::max_element(colorFrequency.begin(), colorFrequency.end(),
-                                            [](const auto &a, const auto &b)
-                                            { return a.second < b.second; });
+    blendSampler.active = true;
+    blendSampler.centerX = centerX;
+    blendSampler.centerY = centerY;
+    blendSampler.radius = radius;
+}
 
-    if (mostCommonColor != colorFrequency.end()) { return *mostCommonColor; }
-    else { return std::make_pair(0, 0); }
+void Canvas::countBlendSamplesOutside(int y, int x, int end, int otherX, int otherEnd, int sign)
+{
+    if (x >= end) return;
+    if (otherX >= otherEnd || otherEnd <= x || otherX >= end) {
+        countBlendSamples(y, x, end, sign);
+        return;
+    }
+    if (x < otherX) { countBlendSamples(y, x, otherX, sign); }
+    if (otherEnd < end) { countBlendSamples(y, otherEnd, end, sign); }
+}
+
+void Canvas::countBlendSamples(int y, int x, int end, int sign)
+{
+    forEachRowSegment(y, x, end, [this, sign](int tileIndex, int row, int column, int count)
+    {
+        const Tile *tile = tiles[tileIndex].get();
+        if (tile) { countColors(&tile->pixels[row * tileSize + column], count, blendSampler.histogram, sign); }
+    });
 }
\ No newline at end of file
@@ -2,11 +2,19 @@
 #define CANVAS_H
 
 #include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <unordered_map>
 #include <optional>
 #include "../mixbox/mixbox.h"
+#include "RingBuffer.h"
+#include "ColorHistogram.h"
+#include "BlendSampler.h"
+#include "WorkerPool.h"
 #include <functional>
 
 class Canvas {
@@ -15,31 +23,169 @@ public:
 
     void setTextureOffset(int x, int y);
     void setTextureZoom(float zoom, int mouseX, int mouseY);
+    // Maps a point on the virtual grid of the window to the virtual grid of the canvas, through zoom and pan
+    [[nodiscard]] std::pair<int, int> toCanvasCoordinates(int x, int y) const;
+    // Coordinates are canvas grid coordinates, painting may run on a thread other than the renderer's.
+    // Strokes are stamped every brushSpacing * radius display pixels from (x2, y2) to (x1, y1)
     void setPixel(int x1, int y1, int x2, int y2, uint32_t color, int blend, int brushSize);
-    void rebuildHighResPixels(SDL_Renderer* renderer);
-    void resetCanvas(SDL_Renderer* renderer);
+    // Clears the blend colors and the spacing carried between segments
+    void endStroke();
+    void rebuildHighResPixels();
+    void updateTexture();
+    void render();
+    [[nodiscard]] bool hasDamage() const { return damaged; }
+    void resetCanvas();
     [[nodiscard]] uint32_t getPixel(int x, int y) const;
-    [[nodiscard]] std::pair<uint32_t, int> getMostCommonColorInRadius(int centerX, int centerY, int maxRadius, uint32_t excludeColor) const;
-    std::unique_ptr<SDL_Texture, decltype(&SDL_DestroyTexture)> texture;
     SDL_Rect srcRect;
     std::optional<uint32_t> firstBlendColor, secondBlendColor;
+    // Reset together with the blend colors when a stroke ends
+    BlendSampler blendSampler;
+    // Stamp distance as a fraction of the brush radius
+    float brushSpacing;
+    // Curve strokes through their samples with Catmull-Rom instead of straight segments
+    bool smoothStrokes;
 
 private:
+    // A queued disc stamp, centered in display canvas pixels
     struct PixelInfo {
         int x, y;
         uint32_t color;
         int radius;
+        PixelInfo() = default;
         PixelInfo(int x, int y, uint32_t color, int radius) : x(x), y(y), color(color), radius(radius) {}
     };
 
+    struct StrokePoint {
+        float x, y;
+    };
+
+    // One row run [x, end) of a queued stamp, collected so overlapping stamps are filled once
+    struct Span {
+        int y, x, end;
+    };
+
+    // A merged run clipped to one tile, with the part of it under the live blend sample
+    struct TileSegment {
+        int row, column, count;
+        uint32_t color;
+        int sampledColumn, sampledCount;
+    };
+
+    // Everything one flush paints into a tile, in queue order
+    struct TileWork {
+        int tileIndex = 0;
+        std::vector<TileSegment> segments;
+        ColorHistogram samplerDelta;
+    };
+
+    // The canvas is stored as tileSize x tileSize tiles, allocated on their first write so
+    // blank areas of large canvases cost one null pointer per tile. Each tile keeps the counts
+    // of its sampled colors, updated as stamps write, for blend queries over large discs
+    struct Tile {
+        std::vector<uint32_t> pixels;
+        ColorHistogram histogram;
+        Tile();
+    };
+
+    static constexpr int tileSize = 64;
+    static constexpr uint32_t blankPixel = 0xFFFFFF00;
+    // Flushes smaller than this many pixels are painted on the calling thread
+    static constexpr size_t parallelPaintThreshold = 1 << 16;
+
     int virtualCanvasWidth, virtualCanvasHeight;
     int displayCanvasWidth, displayCanvasHeight;
     int windowWidth, windowHeight;
-    std::vector<uint32_t> pixels;
+    SDL_Renderer* renderer;
+    int tilesX, tilesY;
+    std::vector<std::unique_ptr<Tile>> tiles;
+    // Render thread only; SDL textures are created, updated and destroyed in updateTexture,
+    // never on the thread that paints or resets the tiles
+    std::vector<std::unique_ptr<SDL_Texture, decltype(&SDL_DestroyTexture)>> tileTextures;
+    // Set once a tile's pixels are final, so the render thread only uploads finished tiles
+    std::vector<std::atomic<uint8_t>> dirtyTiles;
+    std::atomic<bool> damaged;
+    // Held while a tile is written or read across threads; the painting side reads its own
+    // tiles without it, since only it writes them
+    mutable std::vector<std::mutex> tileMutexes;
     int originalWidth, originalHeight;
-    std::unique_ptr<SDL_PixelFormat, decltype(&SDL_FreeFormat)> format;
-    std::queue<PixelInfo> drawOrder;
+    bool strokeStarted;
+    float strokeCarriedDistance;
+    std::optional<StrokePoint> strokeBeforeSegment;
+    RingBuffer<PixelInfo> drawOrder;
+    std::vector<Span> coalescedSpans;
+    std::vector<TileWork> tileWork;
+    std::vector<int> tileWorkSlot;
+    size_t activeTileWork;
+    WorkerPool workerPool;
+    mutable std::unordered_map<int, std::vector<int>> stampSpanCache;
+    std::unique_ptr<mixbox_latent_cache, decltype(&mixbox_latent_cache_destroy)> latentCache;
     uint32_t blendColors(int radius, int frequency);
+    void queueStamp(StrokePoint center, uint32_t color, int radius);
+    void stampAlong(StrokePoint from, StrokePoint to, uint32_t color, int radius);
+    std::pair<uint32_t, int> sampleBlendColor(int centerX, int centerY, int radius, uint32_t excludeColor);
+    void moveBlendSampler(int centerX, int centerY, int radius);
+    void countBlendSamples(int y, int x, int end, int sign);
+    void countDiscColors(int centerX, int centerY, int radius, ColorHistogram &histogram) const;
+    static void countColors(const uint32_t *pixels, int count, ColorHistogram &histogram, int sign);
+    void countBlendSamplesOutside(int y, int x, int end, int otherX, int otherEnd, int sign);
+    void queueTileSegment(int tileIndex, const TileSegment &segment);
+    void paintTileWork(TileWork &work);
+    void markTileDamaged(int tileIndex);
+    [[nodiscard]] uint32_t pixelAt(int x, int y) const;
+    [[nodiscard]] const std::vector<int> &stampSpans(int radius) const;
+    [[nodiscard]] static bool isSampledColor(uint32_t color)
+    {
+        return color != 0x00FFFFFF && color != 0x00000000 && color != blankPixel;
+    }
+
+    // Sets [x, end) to row y of a disc stamp clipped to the canvas; false if the row misses it
+    bool stampRowExtent(int centerX, int centerY, int radius, int y, int &x, int &end) const
+    {
+        if (radius < 0 || y < std::max(centerY - radius, 0) || y > std::min(centerY + radius, displayCanvasHeight - 1)) {
+            return false;
+        }
+        int halfWidth = stampSpans(radius)[y - (centerY - radius)];
+        x = std::max(centerX - halfWidth, 0);
+        end = std::min(centerX + halfWidth + 1, displayCanvasWidth);
+        return x < end;
+    }
+
+    // Calls row(y, x, end) for the part of each row of a disc stamp that lies inside the canvas
+    template<typename Row>
+    void forEachStampRow(int centerX, int centerY, int radius, Row row) const
+    {
+        if (radius < 0) return;
+        const std::vector<int> &halfWidths = stampSpans(radius);
+        int firstRow = std::max(centerY - radius, 0);
+        int lastRow = std::min(centerY + radius, displayCanvasHeight - 1);
+        for (int y = firstRow; y <= lastRow; ++y) {
+            int halfWidth = halfWidths[y - (centerY - radius)];
+            int x = std::max(centerX - halfWidth, 0);
+            int end = std::min(centerX + halfWidth + 1, displayCanvasWidth);
+            if (x < end) { row(y, x, end); }
+        }
+    }
+
+    // Splits the row run [x, end) at tile edges, calling segment(tileIndex, row, column, count)
+    // for each piece so every call covers pixels contiguous in one tile
+    template<typename Segment>
+    void forEachRowSegment(int y, int x, int end, Segment segment) const
+    {
+        while (x < end) {
+            int runEnd = std::min((x / tileSize + 1) * tileSize, end);
+            segment((y / tileSize) * tilesX + x / tileSize, y % tileSize, x % tileSize, runEnd - x);
+            x = runEnd;
+        }
+    }
+
+    template<typename Segment>
+    void forEachStampSegment(int centerX, int centerY, int radius, Segment segment) const
+    {
+        forEachStampRow(centerX, centerY, radius, [this, &segment](int y, int x, int end)
+        {
+            forEachRowSegment(y, x, end, segment);
+        });
+    }
 };
 
 #endif // CANVAS_H
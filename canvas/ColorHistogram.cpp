@@ -0,0 +1,114 @@
+#include "ColorHistogram.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLOR_HISTOGRAM_SSE2
+#endif
+
+ColorHistogram::ColorHistogram() : keys(initialCapacity), counts(initialCapacity, 0), used(initialCapacity, 0),
+                                   lastSlot(0)
+{
+    order.reserve(initialCapacity / 2);
+}
+
+void ColorHistogram::clear()
+{
+    for (uint32_t slot: order) {
+        counts[slot] = 0;
+        used[slot] = 0;
+    }
+    order.clear();
+}
+
+size_t ColorHistogram::slotFor(uint32_t color) const
+{
+    size_t mask = keys.size() - 1;
+    size_t slot = (color * 0x9E3779B1u) & mask;
+    while (used[slot] && keys[slot] != color) { slot = (slot + 1) & mask; }
+    return slot;
+}
+
+void ColorHistogram::add(uint32_t color, int count)
+{
+    // Neighbouring runs are usually the same color, so try the previous slot before hashing
+    if (used[lastSlot] && keys[lastSlot] == color) {
+        counts[lastSlot] += count;
+        return;
+    }
+
+    size_t slot = slotFor(color);
+    if (!used[slot]) {
+        if ((order.size() + 1) * 2 > keys.size()) {
+            rehash();
+            slot = slotFor(color);
+        }
+        keys[slot] = color;
+        used[slot] = 1;
+        order.push_back(static_cast<uint32_t>(slot));
+    }
+    counts[slot] += count;
+    lastSlot = slot;
+}
+
+void ColorHistogram::merge(const ColorHistogram &other)
+{
+    for (uint32_t slot: other.order) {
+        if (other.counts[slot] != 0) { add(other.keys[slot], other.counts[slot]); }
+    }
+}
+
+void ColorHistogram::rehash()
+{
+    // Colors a moving window has left behind are dropped rather than carried over, and the
+    // table only doubles when the colors still counted would keep it over a quarter full
+    size_t live = 0;
+    for (uint32_t slot: order) { live += counts[slot] != 0; }
+    size_t capacity = live * 4 > keys.size() ? keys.size() * 2 : keys.size();
+
+    std::vector<uint32_t> oldKeys = std::move(keys);
+    std::vector<int> oldCounts = std::move(counts);
+    std::vector<uint32_t> oldOrder = std::move(order);
+    keys.assign(capacity, 0);
+    counts.assign(capacity, 0);
+    used.assign(capacity, 0);
+    order.clear();
+
+    for (uint32_t slot: oldOrder) {
+        if (oldCounts[slot] == 0) continue;
+        size_t newSlot = slotFor(oldKeys[slot]);
+        keys[newSlot] = oldKeys[slot];
+        counts[newSlot] = oldCounts[slot];
+        used[newSlot] = 1;
+        order.push_back(static_cast<uint32_t>(newSlot));
+    }
+    lastSlot = order.empty() ? 0 : order.back();
+}
+
+std::pair<uint32_t, int> ColorHistogram::mostCommon(uint32_t excludeColor) const
+{
+    std::pair<uint32_t, int> best(0, 0);
+    for (uint32_t slot: order) {
+        if (counts[slot] > best.second && keys[slot] != excludeColor) { best = {keys[slot], counts[slot]}; }
+    }
+    return best;
+}
+
+int ColorHistogram::runLength(const uint32_t *pixels, int count)
+{
+    int length = 1;
+#ifdef COLOR_HISTOGRAM_SSE2
+    __m128i color = _mm_set1_epi32(static_cast<int>(pixels[0]));
+    for (; length + 4 <= count; length += 4) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + length));
+        int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, color)));
+        if (equal != 0xF) {
+            // The first differing lane ends the run
+            int lane = 0;
+            while (equal & (1 << lane)) { ++lane; }
+            return length + lane;
+        }
+    }
+#endif
+    while (length < count && pixels[length] == pixels[0]) { ++length; }
+    return length;
+}
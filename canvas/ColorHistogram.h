@@ -0,0 +1,39 @@
+#ifndef COLOR_HISTOGRAM_H
+#define COLOR_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open-addressing color counter that keeps its storage between uses, so sampling a brush
+// area allocates nothing once the table has grown to the number of colors it usually sees.
+// Counts may be added and removed, which lets a histogram follow a moving window
+class ColorHistogram {
+public:
+    ColorHistogram();
+
+    void clear();
+    void add(uint32_t color, int count);
+    void merge(const ColorHistogram &other);
+    // Most frequent color other than excludeColor and its count, ties going to the color added
+    // first; (0, 0) when nothing else has a positive count
+    [[nodiscard]] std::pair<uint32_t, int> mostCommon(uint32_t excludeColor) const;
+
+    // Length of the run of pixels equal to pixels[0], at most count
+    static int runLength(const uint32_t *pixels, int count);
+
+private:
+    static constexpr size_t initialCapacity = 64;
+
+    std::vector<uint32_t> keys;
+    std::vector<int> counts;
+    std::vector<uint8_t> used;
+    std::vector<uint32_t> order;
+    size_t lastSlot;
+
+    [[nodiscard]] size_t slotFor(uint32_t color) const;
+    void rehash();
+};
+
+#endif // COLOR_HISTOGRAM_H
@@ -0,0 +1,52 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// FIFO over preallocated storage; capacity is a power of two and only grows if a burst overflows it
+template<typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : slots(roundUpPowerOfTwo(capacity)), head(0), count(0) {}
+
+    template<typename... Args>
+    void emplace(Args &&... args)
+    {
+        if (count == slots.size()) { grow(); }
+        slots[(head + count) & (slots.size() - 1)] = T(std::forward<Args>(args)...);
+        ++count;
+    }
+
+    [[nodiscard]] const T &front() const { return slots[head]; }
+    void pop()
+    {
+        head = (head + 1) & (slots.size() - 1);
+        --count;
+    }
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] size_t size() const { return count; }
+
+private:
+    std::vector<T> slots;
+    size_t head, count;
+
+    static size_t roundUpPowerOfTwo(size_t value)
+    {
+        size_t capacity = 1;
+        while (capacity < value) { capacity <<= 1; }
+        return capacity;
+    }
+
+    void grow()
+    {
+        std::vector<T> larger(slots.size() * 2);
+        for (size_t i = 0; i < count; ++i) { larger[i] = slots[(head + i) & (slots.size() - 1)]; }
+        slots = std::move(larger);
+        head = 0;
+    }
+};
+
+#endif // RING_BUFFER_H
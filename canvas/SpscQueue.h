@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread. Each side
+// only writes its own index, and a blocked side sleeps on the other's index with atomic wait
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(roundUpPowerOfTwo(capacity)), head(0), tail(0) {}
+
+    // Producer side; waits while the queue is full
+    void push(const T &value)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        size_t consumed = head.load(std::memory_order_acquire);
+        while (position - consumed == slots.size()) {
+            head.wait(consumed, std::memory_order_acquire);
+            consumed = head.load(std::memory_order_acquire);
+        }
+        slots[position & (slots.size() - 1)] = value;
+        tail.store(position + 1, std::memory_order_release);
+        tail.notify_one();
+    }
+
+    // Consumer side; returns false when nothing is queued
+    bool tryPop(T &value)
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) return false;
+        value = slots[position & (slots.size() - 1)];
+        head.store(position + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    // Consumer side; blocks until something is queued
+    void waitForPush() const
+    {
+        tail.wait(head.load(std::memory_order_relaxed), std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+    static size_t roundUpPowerOfTwo(size_t value)
+    {
+        size_t capacity = 1;
+        while (capacity < value) { capacity <<= 1; }
+        return capacity;
+    }
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,96 @@
+#include "StrokeWorker.h"
+
+StrokeWorker::StrokeWorker(Canvas &canvas)
+    : canvas(canvas), samples(4096), paintedEvent(SDL_RegisterEvents(1)), unflushedPaint(false), thread(&StrokeWorker::run, this) {}
+
+StrokeWorker::~StrokeWorker()
+{
+    samples.push({Sample::Kind::Stop, 0});
+    thread.join();
+}
+
+void StrokeWorker::paint(Uint32 timestamp, int x1, int y1, int x2, int y2, uint32_t color, int blend, int brushSize)
+{
+    samples.push({Sample::Kind::Paint, timestamp, x1, y1, x2, y2, color, blend, brushSize});
+    unflushedPaint = true;
+}
+
+void StrokeWorker::flush(Uint32 timestamp)
+{
+    if (!unflushedPaint) return;
+    samples.push({Sample::Kind::Flush, timestamp});
+    unflushedPaint = false;
+}
+
+void StrokeWorker::endStroke(Uint32 timestamp)
+{
+    samples.push({Sample::Kind::EndStroke, timestamp});
+}
+
+void StrokeWorker::resetCanvas(Uint32 timestamp)
+{
+    samples.push({Sample::Kind::ResetCanvas, timestamp});
+}
+
+void StrokeWorker::run()
+{
+    Sample sample;
+    while (true) {
+        if (!samples.tryPop(sample)) {
+            samples.waitForPush();
+            continue;
+        }
+
+        switch (sample.kind) {
+            case Sample::Kind::Paint:
+                // Blending samples the canvas under the brush, so its segments cannot wait for the frame
+                if (sample.blend) {
+                    paintPolyline();
+                    canvas.setPixel(sample.x1, sample.y1, sample.x2, sample.y2, sample.color, sample.blend, sample.brushSize);
+                    canvas.rebuildHighResPixels();
+                    notifyPainted();
+                } else {
+                    polyline.push_back(sample);
+                }
+                break;
+
+            case Sample::Kind::Flush:
+                paintPolyline();
+                break;
+
+            case Sample::Kind::EndStroke:
+                paintPolyline();
+                canvas.endStroke();
+                break;
+
+            case Sample::Kind::ResetCanvas:
+                paintPolyline();
+                canvas.resetCanvas();
+                notifyPainted();
+                break;
+
+            case Sample::Kind::Stop:
+                return;
+        }
+    }
+}
+
+void StrokeWorker::paintPolyline()
+{
+    if (polyline.empty()) return;
+    // Every segment queues its stamps, the shared joints coalesce away, and the tiles are written once
+    for (const Sample &segment: polyline) {
+        canvas.setPixel(segment.x1, segment.y1, segment.x2, segment.y2, segment.color, segment.blend, segment.brushSize);
+    }
+    canvas.rebuildHighResPixels();
+    polyline.clear();
+    notifyPainted();
+}
+
+void StrokeWorker::notifyPainted()
+{
+    if (paintedEvent == static_cast<Uint32>(-1)) return;
+    SDL_Event event{};
+    event.type = paintedEvent;
+    SDL_PushEvent(&event);
+}
@@ -0,0 +1,56 @@
+#ifndef STROKE_WORKER_H
+#define STROKE_WORKER_H
+
+#include <SDL.h>
+#include <thread>
+#include <vector>
+#include "Canvas.h"
+#include "SpscQueue.h"
+
+// Paints strokes on its own thread so slow stamps never hold up event handling or present.
+// The event thread queues timestamped samples; the render thread keeps uploading whatever
+// tiles the worker has finished through Canvas::updateTexture. Paint segments queued during
+// a frame form one polyline that is stamped and flushed once when the frame calls flush().
+// Every finished flush pushes an SDL event so a loop sleeping in SDL_WaitEventTimeout wakes to present it
+class StrokeWorker {
+public:
+    explicit StrokeWorker(Canvas &canvas);
+    ~StrokeWorker();
+
+    StrokeWorker(const StrokeWorker &) = delete;
+    StrokeWorker &operator=(const StrokeWorker &) = delete;
+
+    // Coordinates are canvas grid coordinates from Canvas::toCanvasCoordinates
+    void paint(Uint32 timestamp, int x1, int y1, int x2, int y2, uint32_t color, int blend, int brushSize);
+    // Ends the frame's polyline; does nothing if no paint segments were queued since the last flush
+    void flush(Uint32 timestamp);
+    void endStroke(Uint32 timestamp);
+    void resetCanvas(Uint32 timestamp);
+    // Producer side, true while paint is queued that no flush() has ended yet
+    [[nodiscard]] bool hasUnflushedPaint() const { return unflushedPaint; }
+
+private:
+    struct Sample {
+        enum class Kind { Paint, Flush, EndStroke, ResetCanvas, Stop } kind = Kind::Stop;
+        Uint32 timestamp = 0;
+        int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+        uint32_t color = 0;
+        int blend = 0, brushSize = 0;
+    };
+
+    Canvas &canvas;
+    SpscQueue<Sample> samples;
+    Uint32 paintedEvent;
+    // Producer side only
+    bool unflushedPaint;
+    // Worker side only, the segments of the current frame with their event timestamps
+    std::vector<Sample> polyline;
+    // Last, so everything the worker touches exists before it starts
+    std::thread thread;
+
+    void run();
+    void paintPolyline();
+    void notifyPainted();
+};
+
+#endif // STROKE_WORKER_H
@@ -0,0 +1,61 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned threadCount)
+    : task(nullptr), taskCount(0), nextTask(0), busyThreads(0), batch(0), stopping(false)
+{
+    for (unsigned i = 0; i < threadCount; ++i) { threads.emplace_back(&WorkerPool::workerLoop, this); }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread: threads) { thread.join(); }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)> &work)
+{
+    if (threads.empty() || count < 2) {
+        for (size_t i = 0; i < count; ++i) { work(i); }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &work;
+        taskCount = count;
+        nextTask.store(0, std::memory_order_relaxed);
+        busyThreads = threads.size();
+        ++batch;
+    }
+    wake.notify_all();
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return busyThreads == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::workerLoop()
+{
+    uint64_t seenBatch = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this, seenBatch] { return stopping || batch != seenBatch; });
+        if (stopping) return;
+        seenBatch = batch;
+
+        lock.unlock();
+        runTasks();
+        lock.lock();
+        if (--busyThreads == 0) { finished.notify_one(); }
+    }
+}
+
+void WorkerPool::runTasks()
+{
+    for (size_t i = nextTask.fetch_add(1); i < taskCount; i = nextTask.fetch_add(1)) { (*task)(i); }
+}
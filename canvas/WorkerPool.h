@@ -0,0 +1,41 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads that, together with the caller, run the indices of one batch at a time
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Calls task(i) for every i in [0, count) and returns once all calls have finished
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+    [[nodiscard]] size_t threadCount() const { return threads.size(); }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    const std::function<void(size_t)> *task;
+    size_t taskCount;
+    std::atomic<size_t> nextTask;
+    size_t busyThreads;
+    uint64_t batch;
+    bool stopping;
+
+    void workerLoop();
+    void runTasks();
+};
+
+#endif // WORKER_POOL_H
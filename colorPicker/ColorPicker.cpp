@@ -1,4 +1,5 @@
 #include "ColorPicker.h"
+#include <algorithm>
 
 ColorPicker::ColorPicker(SDL_Window *parentWindow, TTF_Font *font)
 {
@@ -7,10 +8,18 @@ ColorPicker::ColorPicker(SDL_Window *parentWindow, TTF_Font *font)
     this->subWindow = nullptr;
     this->subRenderer = nullptr;
     this->subWindowOpen = false;
+    this->needsRedraw = false;
+    this->lastPresent = 0;
+    this->gradientTexture = nullptr;
+    this->hueTexture = nullptr;
+    this->gradientHue = 0;
+    this->glyphAtlas = {};
+    this->infoTextColor = {-1, -1, -1};
 }
 
 ColorPicker::~ColorPicker()
 {
+    destroyTextures();
     if (subRenderer) {
         SDL_DestroyRenderer(subRenderer);
     }
@@ -29,12 +38,14 @@ HSVColor ColorPicker::ShowPicker(const HSVColor &initialColor)
 
     this->currentColor = initialColor;
     this->subWindowOpen = true;
+    this->needsRedraw = true;
 
     while (subWindowOpen) {
         processEvents();
         render();
     }
 
+    destroyTextures();
     SDL_DestroyRenderer(subRenderer);
     SDL_DestroyWindow(subWindow);
     subRenderer = nullptr;
@@ -58,12 +69,18 @@ UIState uiState = UI_NONE;
 
 void ColorPicker::processEvents()
 {
+    // Sleep until input arrives; with a redraw pending only until its frame is due
+    Uint32 frameMilliseconds = 1000 / maxFramesPerSecond;
+    Uint32 sincePresent = SDL_GetTicks() - lastPresent;
+    int timeout = !needsRedraw ? 1000 : static_cast<int>(frameMilliseconds - std::min(sincePresent, frameMilliseconds));
+    if (SDL_WaitEventTimeout(&subEvent, timeout) == 0) return;
 
-    while (SDL_PollEvent(&subEvent) != 0) {
+    do {
         switch (subEvent.type) {
             case SDL_WINDOWEVENT:
                 if (subEvent.window.event == SDL_WINDOWEVENT_CLOSE)
                     subWindowOpen = false;
+                needsRedraw = true;
                 break;
 
             case SDL_MOUSEBUTTONDOWN:
@@ -81,25 +98,71 @@ void ColorPicker::processEvents()
                     currentColor.h =
                         static_cast<double>(clamp(0, HUE_GRADIENT_WIDTH, mouseState.x)) / HUE_GRADIENT_WIDTH * 360.0;
                 }
+                needsRedraw = needsRedraw || uiState != UI_NONE;
                 break;
 
             case SDL_MOUSEBUTTONUP:
                 uiState = UI_NONE;
                 break;
         }
-    }
+    } while (SDL_PollEvent(&subEvent) != 0);
 }
 
 void ColorPicker::render()
 {
+    if (!needsRedraw || SDL_GetTicks() - lastPresent < 1000u / maxFramesPerSecond) return;
+
     SDL_SetRenderDrawColor(subRenderer, 0, 0, 0, 255);
     SDL_RenderClear(subRenderer);
 
-    draw_gradient(subRenderer, currentColor.h);
-    draw_hue_gradient(subRenderer);
+    if (!hueTexture) {
+        hueTexture = create_gradient_texture(subRenderer, HUE_GRADIENT_WIDTH, HUE_GRADIENT_HEIGHT);
+        fill_hue_gradient(hueTexture);
+    }
+    if (!gradientTexture || gradientHue != currentColor.h) {
+        if (!gradientTexture) { gradientTexture = create_gradient_texture(subRenderer, MAIN_GRADIENT_SIZE, MAIN_GRADIENT_SIZE); }
+        fill_gradient(gradientTexture, currentColor.h);
+        gradientHue = currentColor.h;
+    }
+
+    draw_gradient(subRenderer, gradientTexture);
+    draw_hue_gradient(subRenderer, hueTexture);
     draw_hue_slider(subRenderer, currentColor.h);
     draw_sample_box(subRenderer, from_RGBColor(hsv_to_rgb(currentColor)));
-    draw_info_text(subRenderer, currentColor, font);
+    if (!glyphAtlas.texture) {
+        build_glyph_atlas(subRenderer, font, "RGBHSV: 0123456789", &glyphAtlas);
+        infoTextVertices.clear();
+    }
+    bool infoTextChanged = currentColor.h != infoTextColor.h || currentColor.s != infoTextColor.s
+        || currentColor.v != infoTextColor.v;
+    if (glyphAtlas.texture && (infoTextVertices.empty() || infoTextChanged)) {
+        build_info_text(&glyphAtlas, currentColor, infoTextVertices, infoTextIndices);
+        infoTextColor = currentColor;
+    }
+    if (glyphAtlas.texture && !infoTextVertices.empty()) {
+        SDL_RenderGeometry(subRenderer,
+                           glyphAtlas.texture,
+                           infoTextVertices.data(),
+                           static_cast<int>(infoTextVertices.size()),
+                           infoTextIndices.data(),
+                           static_cast<int>(infoTextIndices.size()));
+    }
 
     SDL_RenderPresent(subRenderer);
+    needsRedraw = false;
+    lastPresent = SDL_GetTicks();
 }
+
+
+void ColorPicker::destroyTextures()
+{
+    if (gradientTexture) {
+        SDL_DestroyTexture(gradientTexture);
+        gradientTexture = nullptr;
+    }
+    if (hueTexture) {
+        SDL_DestroyTexture(hueTexture);
+        hueTexture = nullptr;
+    }
+    destroy_glyph_atlas(&glyphAtlas);
+}
\ No newline at end of file
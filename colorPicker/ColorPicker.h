@@ -15,6 +15,7 @@ public:
     HSVColor ShowPicker(const HSVColor& initialColor = { 1, 1, 1 });
     [[nodiscard]] bool IsOpen() const;
     HSVColor currentColor = { 1, 1, 1 };
+    int maxFramesPerSecond = 60;
 
 private:
     SDL_Window* parentWindow;
@@ -22,9 +23,21 @@ private:
     SDL_Renderer* subRenderer;
     TTF_Font* font;
     bool subWindowOpen;
+    bool needsRedraw;
+    Uint32 lastPresent;
+    // Live with subRenderer; the hue strip never changes and the SV plane follows the hue
+    SDL_Texture* gradientTexture;
+    SDL_Texture* hueTexture;
+    double gradientHue;
+    // Info text is drawn from the atlas as one batch of quads, rebuilt only when the color changes
+    GlyphAtlas glyphAtlas;
+    std::vector<SDL_Vertex> infoTextVertices;
+    std::vector<int> infoTextIndices;
+    HSVColor infoTextColor;
 
     void processEvents();
     void render();
+    void destroyTextures();
 
 };
 
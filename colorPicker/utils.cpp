@@ -1,4 +1,10 @@
 #include "ColorPicker.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILS_SSE2
+#endif
 
 HSVColor rgb_to_hsv(RGBColor in)
 {
@@ -168,75 +174,185 @@ enum UIState get_click_state(MouseState m)
     }
 }
 
-void draw_text(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x, int y)
+void hsv_to_argb8888(const float *h, const float *s, const float *v, int count, Uint32 *out)
 {
-    SDL_Color textColor = {255, 255, 255, 255}; // White color for text
-    SDL_Surface *textSurface = TTF_RenderText_Solid(font, text, textColor);
-    SDL_Texture *textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    if (textTexture != nullptr) {
-        SDL_Rect renderQuad = {x, y, textSurface->w, textSurface->h};
-        SDL_RenderCopy(renderer, textTexture, nullptr, &renderQuad);
-        SDL_DestroyTexture(textTexture);
+    // Branchless form of hsv_to_rgb: channel n is v - v * s * clamp(min(k, 4 - k), 0, 1) with
+    // k = (n + h / 60) mod 6, n being 5 for red, 3 for green and 1 for blue
+    int i = 0;
+#ifdef UTILS_SSE2
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), four = _mm_set1_ps(4.0f), six = _mm_set1_ps(6.0f);
+    const __m128 scale = _mm_set1_ps(255.0f), sixtieth = _mm_set1_ps(1.0f / 60.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 sector = _mm_mul_ps(_mm_loadu_ps(h + i), sixtieth);
+        sector = _mm_andnot_ps(_mm_cmpge_ps(sector, six), sector);
+        __m128 value = _mm_loadu_ps(v + i);
+        __m128 chroma = _mm_mul_ps(value, _mm_loadu_ps(s + i));
+
+        auto channel = [&](float n)
+        {
+            __m128 k = _mm_add_ps(sector, _mm_set1_ps(n));
+            k = _mm_sub_ps(k, _mm_and_ps(_mm_cmpge_ps(k, six), six));
+            __m128 ramp = _mm_max_ps(zero, _mm_min_ps(one, _mm_min_ps(k, _mm_sub_ps(four, k))));
+            return _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(value, _mm_mul_ps(chroma, ramp)), scale));
+        };
+
+        __m128i argb = _mm_or_si128(_mm_set1_epi32(static_cast<int>(0xFF000000)),
+                                    _mm_or_si128(_mm_slli_epi32(channel(5.0f), 16),
+                                                 _mm_or_si128(_mm_slli_epi32(channel(3.0f), 8), channel(1.0f))));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), argb);
+    }
+#endif
+    for (; i < count; i++) {
+        float sector = h[i] / 60.0f;
+        if (sector >= 6.0f) sector = 0.0f;
+        float chroma = v[i] * s[i];
+
+        auto channel = [&](float n)
+        {
+            float k = sector + n;
+            if (k >= 6.0f) k -= 6.0f;
+            float ramp = std::max(0.0f, std::min(1.0f, std::min(k, 4.0f - k)));
+            return static_cast<Uint32>((v[i] - chroma * ramp) * 255.0f);
+        };
+
+        out[i] = 0xFF000000 | (channel(5.0f) << 16) | (channel(3.0f) << 8) | channel(1.0f);
     }
-    SDL_FreeSurface(textSurface);
 }
 
-void set_pixel(SDL_Surface *surface, SDL_Color color, int x, int y)
+SDL_Texture *create_gradient_texture(SDL_Renderer *renderer, int width, int height)
 {
-    auto *pixels = (Uint32 *) surface->pixels;
-    Uint32 pixel_color = SDL_MapRGBA(surface->format, color.r, color.g, color.b, color.a);
+    return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+}
 
-    pixels[(y * surface->w) + x] = pixel_color;
+void fill_gradient(SDL_Texture *texture, double hue)
+{
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) return;
+
+    float hues[MAIN_GRADIENT_SIZE], saturations[MAIN_GRADIENT_SIZE], values[MAIN_GRADIENT_SIZE];
+    for (int x = 0; x < MAIN_GRADIENT_SIZE; x++) {
+        hues[x] = (float) hue;
+        saturations[x] = (float) x / MAIN_GRADIENT_SIZE;
+    }
+    for (int y = 0; y < MAIN_GRADIENT_SIZE; y++) {
+        std::fill_n(values, MAIN_GRADIENT_SIZE, 1.0f - (float) y / MAIN_GRADIENT_SIZE);
+        hsv_to_argb8888(hues, saturations, values, MAIN_GRADIENT_SIZE, (Uint32 *) ((Uint8 *) pixels + y * pitch));
+    }
+    SDL_UnlockTexture(texture);
 }
 
-void draw_gradient(SDL_Renderer *renderer, double hue)
+void fill_hue_gradient(SDL_Texture *texture)
 {
-    SDL_Surface *surface = SDL_CreateRGBSurface(0,
-                                                MAIN_GRADIENT_SIZE,
-                                                MAIN_GRADIENT_SIZE,
-                                                32,
-                                                0x00FF0000,
-                                                0x0000FF00,
-                                                0x000000FF,
-                                                0xFF000000);
-    for (int y = 0; y < surface->h; y++) {
-        for (int x = 0; x < surface->w; x++) {
-            HSVColor hsv_color = {hue, (double) x / surface->w, 1.0 - (double) y / surface->h};
-            set_pixel(surface, from_RGBColor(hsv_to_rgb(hsv_color)), x, y);
-        }
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) return;
+
+    float hues[HUE_GRADIENT_WIDTH], saturations[HUE_GRADIENT_WIDTH], values[HUE_GRADIENT_WIDTH];
+    for (int x = 0; x < HUE_GRADIENT_WIDTH; x++) {
+        hues[x] = (float) x / HUE_GRADIENT_WIDTH * 360;
+        saturations[x] = 1.0f;
+        values[x] = 1.0f;
     }
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_Rect render_rect = {0, 0, surface->w, surface->h};
+    for (int y = 0; y < HUE_GRADIENT_HEIGHT; y++) {
+        hsv_to_argb8888(hues, saturations, values, HUE_GRADIENT_WIDTH, (Uint32 *) ((Uint8 *) pixels + y * pitch));
+    }
+    SDL_UnlockTexture(texture);
+}
+
+void draw_gradient(SDL_Renderer *renderer, SDL_Texture *texture)
+{
+    SDL_Rect render_rect = {0, 0, MAIN_GRADIENT_SIZE, MAIN_GRADIENT_SIZE};
+    SDL_RenderCopy(renderer, texture, nullptr, &render_rect);
+}
+
+void draw_hue_gradient(SDL_Renderer *renderer, SDL_Texture *texture)
+{
+    SDL_Rect render_rect = {0, MAIN_GRADIENT_SIZE, HUE_GRADIENT_WIDTH, HUE_GRADIENT_HEIGHT};
     SDL_RenderCopy(renderer, texture, nullptr, &render_rect);
-    SDL_DestroyTexture(texture);
-    SDL_FreeSurface(surface);
 }
 
-void draw_hue_gradient(SDL_Renderer *renderer)
+bool build_glyph_atlas(SDL_Renderer *renderer, TTF_Font *font, const char *characters, GlyphAtlas *atlas)
 {
-    SDL_Surface *surface = SDL_CreateRGBSurface(0,
-                                                HUE_GRADIENT_WIDTH,
-                                                HUE_GRADIENT_HEIGHT,
-                                                32,
-                                                0x00FF0000,
-                                                0x0000FF00,
-                                                0x000000FF,
-                                                0xFF000000);
-    for (int y = 0; y < surface->h; y++) {
-        for (int x = 0; x < surface->w; x++) {
-            HSVColor hsv_color = {(double) x / surface->w * 360, 1.0, 1.0};
-            set_pixel(surface, from_RGBColor(hsv_to_rgb(hsv_color)), x, y);
+    *atlas = {};
+    if (font == nullptr) return false;
+
+    SDL_Color glyphColor = {255, 255, 255, 255};
+    SDL_Surface *glyphSurfaces[128] = {};
+    for (const char *c = characters; *c != '\0'; c++) {
+        auto ch = (unsigned char) *c;
+        if (ch >= 128 || glyphSurfaces[ch] != nullptr) continue;
+
+        glyphSurfaces[ch] = TTF_RenderGlyph_Solid(font, ch, glyphColor);
+        int advance = glyphSurfaces[ch] != nullptr ? glyphSurfaces[ch]->w : 0;
+        TTF_GlyphMetrics(font, ch, nullptr, nullptr, nullptr, nullptr, &advance);
+        atlas->advances[ch] = advance;
+        if (glyphSurfaces[ch] == nullptr) continue;
+
+        // One pixel apart so filtering never bleeds a neighbour in
+        atlas->glyphs[ch] = {atlas->width, 0, glyphSurfaces[ch]->w, glyphSurfaces[ch]->h};
+        atlas->width += glyphSurfaces[ch]->w + 1;
+        atlas->height = std::max(atlas->height, glyphSurfaces[ch]->h);
+    }
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0,
+                                                        std::max(atlas->width, 1),
+                                                        std::max(atlas->height, 1),
+                                                        32,
+                                                        SDL_PIXELFORMAT_ARGB8888);
+    if (sheet != nullptr) { SDL_FillRect(sheet, nullptr, 0); }
+    for (int ch = 0; ch < 128; ch++) {
+        if (glyphSurfaces[ch] == nullptr) continue;
+        if (sheet != nullptr) { SDL_BlitSurface(glyphSurfaces[ch], nullptr, sheet, &atlas->glyphs[ch]); }
+        SDL_FreeSurface(glyphSurfaces[ch]);
+    }
+    if (sheet == nullptr) return false;
+
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    atlas->width = sheet->w;
+    atlas->height = sheet->h;
+    SDL_FreeSurface(sheet);
+    return atlas->texture != nullptr;
+}
+
+void destroy_glyph_atlas(GlyphAtlas *atlas)
+{
+    if (atlas->texture != nullptr) { SDL_DestroyTexture(atlas->texture); }
+    *atlas = {};
+}
+
+void append_atlas_text(const GlyphAtlas *atlas, const char *text, int x, int y,
+                       std::vector<SDL_Vertex> &vertices, std::vector<int> &indices)
+{
+    SDL_Color white = {255, 255, 255, 255};
+    for (const char *c = text; *c != '\0'; c++) {
+        auto ch = (unsigned char) *c;
+        if (ch >= 128) continue;
+
+        const SDL_Rect &glyph = atlas->glyphs[ch];
+        if (glyph.w > 0) {
+            float left = (float) x, top = (float) y, right = left + glyph.w, bottom = top + glyph.h;
+            float u0 = (float) glyph.x / atlas->width, u1 = (float) (glyph.x + glyph.w) / atlas->width;
+            float v0 = (float) glyph.y / atlas->height, v1 = (float) (glyph.y + glyph.h) / atlas->height;
+
+            int first = (int) vertices.size();
+            vertices.push_back({{left, top}, white, {u0, v0}});
+            vertices.push_back({{right, top}, white, {u1, v0}});
+            vertices.push_back({{right, bottom}, white, {u1, v1}});
+            vertices.push_back({{left, bottom}, white, {u0, v1}});
+            for (int corner: {0, 1, 2, 0, 2, 3}) { indices.push_back(first + corner); }
         }
+        x += atlas->advances[ch];
     }
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_Rect render_rect = {0, MAIN_GRADIENT_SIZE, surface->w, surface->h};
-    SDL_RenderCopy(renderer, texture, nullptr, &render_rect);
-    SDL_DestroyTexture(texture);
-    SDL_FreeSurface(surface);
 }
 
-void draw_info_text(SDL_Renderer *renderer, HSVColor hsv_color, TTF_Font *font)
+void build_info_text(const GlyphAtlas *atlas, HSVColor hsv_color,
+                     std::vector<SDL_Vertex> &vertices, std::vector<int> &indices)
 {
+    vertices.clear();
+    indices.clear();
+
     RGBColor rgb_color = hsv_to_rgb(hsv_color);
     char rgb_buffer[128];
     sprintf(rgb_buffer, "R: %d G: %d B: %d",
@@ -244,7 +360,7 @@ void draw_info_text(SDL_Renderer *renderer, HSVColor hsv_color, TTF_Font *font)
             (int) (rgb_color.g * 255),
             (int) (rgb_color.b * 255));
 
-    draw_text(renderer, font, rgb_buffer, 10, MAIN_GRADIENT_SIZE + HUE_GRADIENT_HEIGHT + 10);
+    append_atlas_text(atlas, rgb_buffer, 10, MAIN_GRADIENT_SIZE + HUE_GRADIENT_HEIGHT + 10, vertices, indices);
 
     char hsv_buffer[128];
     sprintf(hsv_buffer, "H: %d S: %d V: %d",
@@ -252,5 +368,5 @@ void draw_info_text(SDL_Renderer *renderer, HSVColor hsv_color, TTF_Font *font)
             (int) (hsv_color.s * 100),
             (int) (hsv_color.v * 100));
 
-    draw_text(renderer, font, hsv_buffer, 10, MAIN_GRADIENT_SIZE + HUE_GRADIENT_HEIGHT + 30);
+    append_atlas_text(atlas, hsv_buffer, 10, MAIN_GRADIENT_SIZE + HUE_GRADIENT_HEIGHT + 30, vertices, indices);
 }
\ No newline at end of file
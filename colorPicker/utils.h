@@ -5,6 +5,7 @@
 #include <SDL_image.h>
 #include <iostream>
 #include <SDL_ttf.h>
+#include <vector>
 
 #define MAIN_GRADIENT_SIZE  (200)
 #define HUE_GRADIENT_WIDTH  (200)
@@ -47,8 +48,27 @@ enum UIState {
 };
 
 enum UIState get_click_state(MouseState m);
-void draw_text(SDL_Renderer* renderer, TTF_Font* font, const char* text, int x, int y);
-void set_pixel(SDL_Surface* surface, SDL_Color color, int x, int y);
-void draw_gradient(SDL_Renderer* renderer, double hue);
-void draw_hue_gradient(SDL_Renderer* renderer);
-void draw_info_text(SDL_Renderer* renderer, HSVColor hsv_color, TTF_Font* font);
+// Converts count pixels to ARGB8888 in float, h in degrees and s, v between 0 and 1
+void hsv_to_argb8888(const float* h, const float* s, const float* v, int count, Uint32* out);
+SDL_Texture* create_gradient_texture(SDL_Renderer* renderer, int width, int height);
+void fill_gradient(SDL_Texture* texture, double hue);
+void fill_hue_gradient(SDL_Texture* texture);
+void draw_gradient(SDL_Renderer* renderer, SDL_Texture* texture);
+void draw_hue_gradient(SDL_Renderer* renderer, SDL_Texture* texture);
+
+// Glyphs of a font packed into one texture, indexed by ASCII code; a zero width means no glyph
+typedef struct {
+    SDL_Texture* texture;
+    int width;
+    int height;
+    SDL_Rect glyphs[128];
+    int advances[128];
+} GlyphAtlas;
+
+bool build_glyph_atlas(SDL_Renderer* renderer, TTF_Font* font, const char* characters, GlyphAtlas* atlas);
+void destroy_glyph_atlas(GlyphAtlas* atlas);
+void append_atlas_text(const GlyphAtlas* atlas, const char* text, int x, int y,
+                       std::vector<SDL_Vertex>& vertices, std::vector<int>& indices);
+// Replaces vertices and indices with the quads of the RGB and HSV lines, drawn with one SDL_RenderGeometry
+void build_info_text(const GlyphAtlas* atlas, HSVColor hsv_color,
+                     std::vector<SDL_Vertex>& vertices, std::vector<int>& indices);
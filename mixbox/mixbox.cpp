@@ -49,259 +49,2353 @@
 
 #include "mixbox.h"
 
+#include <algorithm>
 #include <cmath>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#ifdef _MSC_VER
+  #define INLINE __forceinline
+#elif defined(__GNUC__)
+  #define INLINE inline __attribute__((always_inline))
+#else
+  #define INLINE inline
+#endif
+
+// On x86 every SIMD kernel is compiled regardless of the baseline ISA and picked at
+// runtime, so GCC/Clang need per-function target attributes to emit the instructions.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define MIXBOX_X86
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+  #if defined(__GNUC__) || defined(__clang__)
+    #define MIXBOX_TARGET_SSE41  __attribute__((target("sse4.1")))
+    #define MIXBOX_TARGET_AVX2   __attribute__((target("avx2,fma")))
+    #define MIXBOX_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+  #else
+    #define MIXBOX_TARGET_SSE41
+    #define MIXBOX_TARGET_AVX2
+    #define MIXBOX_TARGET_AVX512
+  #endif
+#endif
+
+INLINE static float clamp01(float x)
+{
+  return x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x;
+}
+
+INLINE static float srgb_to_linear(float x)
+{
+  return (x >= 0.04045f) ? std::pow((x + 0.055f) / 1.055f, 2.4f) : x/12.92f;
+}
+
+INLINE static float linear_to_srgb(float x)
+{
+  return (x >= 0.0031308f) ? 1.055f*std::pow(x, 1.0f/2.4f) - 0.055f : 12.92f*x;
+}
+
+// The fast transfer mode samples both curves at 4096 even steps over [0, 1] and
+// interpolates linearly. Inputs are clamped to [0, 1] first, which changes nothing:
+// rgb->latent clamps right after the transfer and latent->rgb values are already clamped.
+#define MIXBOX_TRANSFER_STEPS 4096
+
+struct mixbox_transfer_tables
+{
+  alignas(64) float to_linear[MIXBOX_TRANSFER_STEPS + 1];
+  alignas(64) float to_srgb[MIXBOX_TRANSFER_STEPS + 1];
+
+  mixbox_transfer_tables()
+  {
+    for (int i = 0; i <= MIXBOX_TRANSFER_STEPS; i++)
+    {
+      const double x = double(i) / MIXBOX_TRANSFER_STEPS;
+      to_linear[i] = float((x >= 0.04045) ? std::pow((x + 0.055) / 1.055, 2.4) : x/12.92);
+      to_srgb[i] = float((x >= 0.0031308) ? 1.055*std::pow(x, 1.0/2.4) - 0.055 : 12.92*x);
+    }
+  }
+};
+
+INLINE static const mixbox_transfer_tables* mixbox_transfer()
+{
+  static const mixbox_transfer_tables tables;
+  return &tables;
+}
+
+INLINE static float transfer_lookup(const float* table, float x)
+{
+  x = clamp01(x) * float(MIXBOX_TRANSFER_STEPS);
+  const int i = x < float(MIXBOX_TRANSFER_STEPS - 1) ? int(x) : MIXBOX_TRANSFER_STEPS - 1;
+  const float t = x - float(i);
+  return table[i] + t*(table[i + 1] - table[i]);
+}
+
+static std::atomic<mixbox_transfer_mode> mixbox_active_transfer(MIXBOX_TRANSFER_EXACT);
+
+INLINE static float transfer_srgb_to_linear(float x)
+{
+  return mixbox_active_transfer.load(std::memory_order_relaxed) == MIXBOX_TRANSFER_FAST ? transfer_lookup(mixbox_transfer()->to_linear, x) : srgb_to_linear(x);
+}
+
+INLINE static float transfer_linear_to_srgb(float x)
+{
+  return mixbox_active_transfer.load(std::memory_order_relaxed) == MIXBOX_TRANSFER_FAST ? transfer_lookup(mixbox_transfer()->to_srgb, x) : linear_to_srgb(x);
+}
+
+// The 20 cubic monomials of the polynomial as TERM(x, y, kr, kg, kb), each adding
+// k*(x*y) to the matching output channel. Shared by the scalar and SIMD evaluators.
+#define MIXBOX_POLYNOMIAL_TERMS(TERM) \
+  TERM(c0 , c00, +0.07717053f, +0.02826978f, +0.24832992f) \
+  TERM(c1 , c11, +0.95912302f, +0.80256528f, +0.03561839f) \
+  TERM(c2 , c22, +0.74683774f, +0.04868586f, +0.00000000f) \
+  TERM(c3 , c33, +0.99518138f, +0.99978149f, +0.99704802f) \
+  TERM(c00, c1 , +0.04819146f, +0.83363781f, +0.32515377f) \
+  TERM(c01, c1 , -0.68146950f, +1.46107803f, +1.06980936f) \
+  TERM(c00, c2 , +0.27058419f, -0.15324870f, +1.98735057f) \
+  TERM(c02, c2 , +0.80478189f, +0.67093710f, +0.18424500f) \
+  TERM(c00, c3 , -0.35031003f, +1.37855826f, +3.68865000f) \
+  TERM(c0 , c33, +1.05128046f, +1.97815239f, +2.82989073f) \
+  TERM(c11, c2 , +3.21607125f, +0.81270228f, +1.03384539f) \
+  TERM(c1 , c22, +2.78893374f, +0.41565549f, -0.04487295f) \
+  TERM(c11, c3 , +3.02162577f, +2.55374103f, +0.32766114f) \
+  TERM(c1 , c33, +2.95124691f, +2.81201112f, +1.17578442f) \
+  TERM(c22, c3 , +2.82677043f, +0.79933038f, +1.81715262f) \
+  TERM(c2 , c33, +2.99691099f, +1.22593053f, +1.80653661f) \
+  TERM(c01, c2 , +1.87394106f, +2.05027182f, -0.29835996f) \
+  TERM(c01, c3 , +2.56609566f, +7.03428198f, +0.62575374f) \
+  TERM(c02, c3 , +4.08329484f, -1.40408358f, +2.14995522f) \
+  TERM(c12, c3 , +6.00078678f, +2.55552042f, +1.90739502f)
+
+INLINE static void eval_polynomial(float c0, float c1, float c2, float c3, float* rgb)
+{
+  float r = 0;
+  float g = 0;
+  float b = 0;
+
+  const float c00 = c0 * c0;
+  const float c11 = c1 * c1;
+  const float c22 = c2 * c2;
+  const float c33 = c3 * c3;
+  const float c01 = c0 * c1;
+  const float c02 = c0 * c2;
+  const float c12 = c1 * c2;
+
+  float w;
+#define MIXBOX_TERM(x, y, kr, kg, kb) w = x*y; r += kr*w; g += kg*w; b += kb*w;
+  MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+
+  rgb[0] = r;
+  rgb[1] = g;
+  rgb[2] = b;
+}
+
+// 64x64x64 rgb entries plus the trailing taps read past the last lattice cell, with one
+// byte of tail padding so the SIMD kernels can fetch every tap as a 32-bit word.
+#define MIXBOX_LUT_SIZE (64*64*64*3 + 12675 + 1)
+
+INLINE static const unsigned char* mixbox_lut();
+INLINE static const unsigned char* mixbox_lut32();
+
+// Byte distance between neighbouring lattice entries along x, y and z of each table.
+#define MIXBOX_LUT64_DX 3
+#define MIXBOX_LUT64_DY (64*3)
+#define MIXBOX_LUT64_DZ (64*64*3)
+#define MIXBOX_LUT32_DX 4
+#define MIXBOX_LUT32_DY (32*4)
+#define MIXBOX_LUT32_DZ (32*32*4)
+
+// The cube around a sample splits into six tetrahedra along its main diagonal. Ordering
+// tx, ty, tz picks the one holding the sample, and only its 4 corners are read: the
+// origin, one step along the largest axis, one more step along the middle axis, and the
+// far corner. Ties resolve so the two middle corners are always distinct. The tetrahedron
+// of random input is unpredictable, so it is selected with bit masks and min/max instead of
+// branches; std::fmin/fmax would be libm calls here, std::min/max compile to minss/maxss.
+INLINE static void tetrahedral_taps(float tx, float ty, float tz, int dx, int dy, int dz, int* offset, float* weight)
+{
+  const int x_max = -int((tx >= ty) & (tx >= tz));
+  const int y_max = ~x_max & -int(ty >= tz);
+  const int z_max = ~(x_max | y_max);
+  const int z_min = -int((tz <= ty) & (tz <= tx));
+  const int y_min = ~z_min & -int((ty <= tx) & (ty <= tz));
+  const int x_min = ~(z_min | y_min);
+
+  const float t_max = std::max(tx, std::max(ty, tz));
+  const float t_min = std::min(tx, std::min(ty, tz));
+  const float t_mid = std::max(std::min(tx, ty), std::min(std::max(tx, ty), tz));
+
+  offset[0] = 0;
+  offset[1] = (x_max & dx) | (y_max & dy) | (z_max & dz);
+  offset[2] = dx + dy + dz - ((z_min & dz) | (y_min & dy) | (x_min & dx));
+  offset[3] = dx + dy + dz;
+
+  weight[0] = 1.0f - t_max;
+  weight[1] = t_max - t_mid;
+  weight[2] = t_mid - t_min;
+  weight[3] = t_min;
+}
+
+// Interpolates the (c0, c1, c2) pigment concentrations at an rgb already clamped to [0, 1].
+template<int mode>
+INLINE static void lut_fetch(float r, float g, float b, float* c)
+{
+  float c0 = 0;
+  float c1 = 0;
+  float c2 = 0;
+
+  if constexpr (mode == MIXBOX_LUT_TRILINEAR)
+  {
+    const float x = r * 63.0f;
+    const float y = g * 63.0f;
+    const float z = b * 63.0f;
+
+    const int ix = int(x);
+    const int iy = int(y);
+    const int iz = int(z);
+
+    const float tx = x - float(ix);
+    const float ty = y - float(iy);
+    const float tz = z - float(iz);
+
+    const unsigned char* const lut_ptr = &(mixbox_lut()[((ix + iy*64 + iz*64*64) & 0x3FFFF) * 3]);
+
+    float w;
+    w = (1.0f-tx)*(1.0f-ty)*(1.0f-tz); c0 += w*lut_ptr[  192]; c1 += w*lut_ptr[  193]; c2 += w*lut_ptr[  194];
+    w = (     tx)*(1.0f-ty)*(1.0f-tz); c0 += w*lut_ptr[  195]; c1 += w*lut_ptr[  196]; c2 += w*lut_ptr[  197];
+    w = (1.0f-tx)*(     ty)*(1.0f-tz); c0 += w*lut_ptr[  384]; c1 += w*lut_ptr[  385]; c2 += w*lut_ptr[  386];
+    w = (     tx)*(     ty)*(1.0f-tz); c0 += w*lut_ptr[  387]; c1 += w*lut_ptr[  388]; c2 += w*lut_ptr[  389];
+    w = (1.0f-tx)*(1.0f-ty)*(     tz); c0 += w*lut_ptr[12480]; c1 += w*lut_ptr[12481]; c2 += w*lut_ptr[12482];
+    w = (     tx)*(1.0f-ty)*(     tz); c0 += w*lut_ptr[12483]; c1 += w*lut_ptr[12484]; c2 += w*lut_ptr[12485];
+    w = (1.0f-tx)*(     ty)*(     tz); c0 += w*lut_ptr[12672]; c1 += w*lut_ptr[12673]; c2 += w*lut_ptr[12674];
+    w = (     tx)*(     ty)*(     tz); c0 += w*lut_ptr[12675]; c1 += w*lut_ptr[12676]; c2 += w*lut_ptr[12677];
+  }
+  else
+  {
+    const bool lut32 = (mode == MIXBOX_LUT_TETRAHEDRAL_32);
+    const float scale = lut32 ? 31.0f : 63.0f;
+
+    const float x = r * scale;
+    const float y = g * scale;
+    const float z = b * scale;
+
+    // the 32^3 table has no padding entries, so the last cell is reused at 1.0
+    const int ix = lut32 ? (x < 31.0f ? int(x) : 30) : int(x);
+    const int iy = lut32 ? (y < 31.0f ? int(y) : 30) : int(y);
+    const int iz = lut32 ? (z < 31.0f ? int(z) : 30) : int(z);
+
+    const unsigned char* const lut_ptr = lut32 ? &(mixbox_lut32()[(ix + iy*32 + iz*32*32) * 4])
+                                               : &(mixbox_lut()[((ix + iy*64 + iz*64*64) & 0x3FFFF) * 3 + 192]);
+
+    int offset[4];
+    float weight[4];
+    tetrahedral_taps(x - float(ix), y - float(iy), z - float(iz),
+                     lut32 ? MIXBOX_LUT32_DX : MIXBOX_LUT64_DX,
+                     lut32 ? MIXBOX_LUT32_DY : MIXBOX_LUT64_DY,
+                     lut32 ? MIXBOX_LUT32_DZ : MIXBOX_LUT64_DZ, offset, weight);
+
+    for (int k = 0; k < 4; k++)
+    {
+      const unsigned char* const tap = lut_ptr + offset[k];
+      c0 += weight[k]*tap[0];
+      c1 += weight[k]*tap[1];
+      c2 += weight[k]*tap[2];
+    }
+  }
+
+  c[0] = c0 * (1.0f / 255.0f);
+  c[1] = c1 * (1.0f / 255.0f);
+  c[2] = c2 * (1.0f / 255.0f);
+}
+
+template<int mode = MIXBOX_LUT_TRILINEAR>
+INLINE static void float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+{
+  r = clamp01(r);
+  g = clamp01(g);
+  b = clamp01(b);
+
+  float c[3];
+  lut_fetch<mode>(r, g, b, c);
+
+  const float c0 = c[0];
+  const float c1 = c[1];
+  const float c2 = c[2];
+  const float c3 = 1.0f - (c0 + c1 + c2);
+
+  float mixrgb[3];
+  eval_polynomial(c0, c1, c2, c3, mixrgb);
+
+  out_latent[0] = c0;
+  out_latent[1] = c1;
+  out_latent[2] = c2;
+  out_latent[3] = c3;
+  out_latent[4] = r - mixrgb[0];
+  out_latent[5] = g - mixrgb[1];
+  out_latent[6] = b - mixrgb[2];
+}
+
+// Per-ISA implementations of the hot paths, selected once by mixbox_dispatch().
+// The scalar entries are the reference functions above.
+struct mixbox_kernels
+{
+  mixbox_isa isa;
+  mixbox_lut_mode lut_mode;
+  void (*float_rgb_to_latent)(float r, float g, float b, mixbox_latent out_latent);
+  void (*eval_polynomial)(float c0, float c1, float c2, float c3, float* rgb);
+  void (*lerp_latent)(const float* latent1, const float* latent2, float t, float* out_latent);
+  void (*rgb_to_latent_n)(const unsigned char* rgb, size_t n, float* latents_soa);
+  void (*latent_to_rgb_n)(const float* latents_soa, size_t n, unsigned char* rgb);
+  void (*float_rgb_to_latent_n)(const float* rgb, size_t n, float* latents_soa, void (*transfer)(float*, size_t));
+  void (*latent_to_float_rgb_n)(const float* latents_soa, size_t n, float* rgb, void (*transfer)(float*, size_t));
+  void (*srgb_to_linear_fast_n)(float* values, size_t count);
+  void (*linear_to_srgb_fast_n)(float* values, size_t count);
+  void (*mix_n_image)(const unsigned char* const* images, const float* weights, int k, size_t n, unsigned char* out_rgb);
+  void (*pack_latent_n)(const float* latents_soa, size_t n, mixbox_packed_latent* packed);
+  void (*unpack_latent_n)(const mixbox_packed_latent* packed, size_t n, float* latents_soa);
+};
+
+INLINE static const mixbox_kernels* mixbox_dispatch();
+
+INLINE static void latent_to_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+{
+  float rgb[3];
+  mixbox_dispatch()->eval_polynomial(latent[0], latent[1], latent[2], latent[3], rgb);
+  *out_r = clamp01(rgb[0] + latent[4]);
+  *out_g = clamp01(rgb[1] + latent[5]);
+  *out_b = clamp01(rgb[2] + latent[6]);
+}
+
+INLINE static void latent_to_rgb(mixbox_latent latent, unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+{
+  float r, g, b;
+  latent_to_float_rgb(latent, &r, &g, &b);
+  *out_r = (unsigned char)((int)(r*255.0f + 0.5f));
+  *out_g = (unsigned char)((int)(g*255.0f + 0.5f));
+  *out_b = (unsigned char)((int)(b*255.0f + 0.5f));
+}
+
+INLINE static void rgb_to_latent(unsigned char r, unsigned char g, unsigned char b, mixbox_latent out_latent)
+{
+  mixbox_dispatch()->float_rgb_to_latent(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f, out_latent);
+}
+
+INLINE static void linear_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+{
+  mixbox_dispatch()->float_rgb_to_latent(transfer_linear_to_srgb(r),
+                                         transfer_linear_to_srgb(g),
+                                         transfer_linear_to_srgb(b),
+                                         out_latent);
+}
+
+INLINE static void latent_to_linear_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+{
+  float rgb[3];
+  latent_to_float_rgb(latent, &rgb[0], &rgb[1], &rgb[2]);
+  *out_r = transfer_srgb_to_linear(rgb[0]);
+  *out_g = transfer_srgb_to_linear(rgb[1]);
+  *out_b = transfer_srgb_to_linear(rgb[2]);
+}
+
+void mixbox_rgb_to_latent(unsigned char r, unsigned char g, unsigned char b, mixbox_latent out_latent)
+{
+  rgb_to_latent(r, g, b, out_latent);
+}
+
+void mixbox_latent_to_rgb(mixbox_latent latent, unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+{
+  latent_to_rgb(latent, out_r, out_g, out_b);
+}
+
+void mixbox_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+{
+  mixbox_dispatch()->float_rgb_to_latent(r, g, b, out_latent);
+}
+
+void mixbox_linear_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+{
+  linear_float_rgb_to_latent(r, g, b, out_latent);
+}
+
+void mixbox_latent_to_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+{
+  latent_to_float_rgb(latent, out_r, out_g, out_b);
+}
+
+void mixbox_latent_to_linear_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+{
+  latent_to_linear_float_rgb(latent, out_r, out_g, out_b);
+}
+
+void mixbox_lerp(unsigned char r1, unsigned char g1, unsigned char b1,
+                 unsigned char r2, unsigned char g2, unsigned char b2,
+                 float t,
+                 unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+{
+  mixbox_latent latent1;
+  mixbox_latent latent2;
+
+  rgb_to_latent(r1, g1, b1, latent1);
+  rgb_to_latent(r2, g2, b2, latent2);
+
+  mixbox_latent latent_mix;
+  mixbox_dispatch()->lerp_latent(latent1, latent2, t, latent_mix);
+
+  latent_to_rgb(latent_mix, out_r, out_g, out_b);
+}
+
+void mixbox_lerp_float(float r1, float g1, float b1,
+                       float r2, float g2, float b2,
+                       float t,
+                       float* out_r, float* out_g, float* out_b)
+{
+  mixbox_latent latent1;
+  mixbox_latent latent2;
+
+  mixbox_dispatch()->float_rgb_to_latent(r1, g1, b1, latent1);
+  mixbox_dispatch()->float_rgb_to_latent(r2, g2, b2, latent2);
+
+  mixbox_latent latent_mix;
+  mixbox_dispatch()->lerp_latent(latent1, latent2, t, latent_mix);
+
+  latent_to_float_rgb(latent_mix, out_r, out_g, out_b);
+}
+
+void mixbox_lerp_linear_float(float r1, float g1, float b1,
+                              float r2, float g2, float b2,
+                              float t,
+                              float* out_r, float* out_g, float* out_b)
+{
+  mixbox_latent latent1;
+  mixbox_latent latent2;
+
+  linear_float_rgb_to_latent(r1, g1, b1, latent1);
+  linear_float_rgb_to_latent(r2, g2, b2, latent2);
+
+  mixbox_latent latent_mix;
+  mixbox_dispatch()->lerp_latent(latent1, latent2, t, latent_mix);
+
+  latent_to_linear_float_rgb(latent_mix, out_r, out_g, out_b);
+}
+
+// Two-way set associative rgb -> latent memo, the most recently used entry of a set sits
+// in its first slot. A slot's key is the packed rgb plus one, so 0 marks an empty slot.
+// Entries are only valid for the kernels they were computed with, which fix both the LUT
+// mode and the ISA, since the SIMD paths round differently from the scalar one.
+struct mixbox_latent_cache
+{
+  struct slot
+  {
+    uint32_t key;
+    float latent[MIXBOX_LATENT_SIZE];
+  };
+
+  slot* slots;
+  int bits;
+  const mixbox_kernels* kernels;
+  unsigned long long hits;
+  unsigned long long misses;
+};
+
+mixbox_latent_cache* mixbox_latent_cache_create(int capacity_log2)
+{
+  if (capacity_log2 < 1) capacity_log2 = 1;
+  if (capacity_log2 > 24) capacity_log2 = 24;
+
+  mixbox_latent_cache* cache = new mixbox_latent_cache();
+  cache->slots = new mixbox_latent_cache::slot[size_t(1) << capacity_log2]();
+  cache->bits = capacity_log2;
+  cache->kernels = mixbox_dispatch();
+  return cache;
+}
+
+void mixbox_latent_cache_destroy(mixbox_latent_cache* cache)
+{
+  if (!cache) return;
+  delete[] cache->slots;
+  delete cache;
+}
+
+void mixbox_latent_cache_clear(mixbox_latent_cache* cache)
+{
+  memset(cache->slots, 0, (size_t(1) << cache->bits) * sizeof(mixbox_latent_cache::slot));
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+void mixbox_latent_cache_stats(const mixbox_latent_cache* cache, unsigned long long* out_hits, unsigned long long* out_misses)
+{
+  if (out_hits) *out_hits = cache->hits;
+  if (out_misses) *out_misses = cache->misses;
+}
+
+void mixbox_cached_rgb_to_latent(mixbox_latent_cache* cache, unsigned char r, unsigned char g, unsigned char b, mixbox_latent out_latent)
+{
+  const mixbox_kernels* const kernels = mixbox_dispatch();
+  if (kernels != cache->kernels)
+  {
+    memset(cache->slots, 0, (size_t(1) << cache->bits) * sizeof(mixbox_latent_cache::slot));
+    cache->kernels = kernels;
+  }
+
+  const uint32_t key = ((uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b)) + 1;
+  mixbox_latent_cache::slot* const set = &cache->slots[((key * 2654435761u) >> (32 - cache->bits)) & ~1u];
+  if (set[0].key == key)
+  {
+    cache->hits++;
+  }
+  else if (set[1].key == key)
+  {
+    const mixbox_latent_cache::slot used = set[1];
+    set[1] = set[0];
+    set[0] = used;
+    cache->hits++;
+  }
+  else
+  {
+    set[1] = set[0];
+    kernels->float_rgb_to_latent(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f, set[0].latent);
+    set[0].key = key;
+    cache->misses++;
+  }
+  memcpy(out_latent, set[0].latent, sizeof(mixbox_latent));
+}
+
+void mixbox_cached_lerp(mixbox_latent_cache* cache,
+                        unsigned char r1, unsigned char g1, unsigned char b1,
+                        unsigned char r2, unsigned char g2, unsigned char b2,
+                        float t,
+                        unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+{
+  mixbox_latent latent1;
+  mixbox_latent latent2;
+
+  mixbox_cached_rgb_to_latent(cache, r1, g1, b1, latent1);
+  mixbox_cached_rgb_to_latent(cache, r2, g2, b2, latent2);
+
+  mixbox_latent latent_mix;
+  mixbox_dispatch()->lerp_latent(latent1, latent2, t, latent_mix);
+
+  latent_to_rgb(latent_mix, out_r, out_g, out_b);
+}
+
+// Packed latents store component i as a 16-bit code over [offset, offset + 65536*step):
+// the concentrations over [-0.25, 1.75) (c3 dips just below 0 near the LUT edges), the
+// residuals over [-0.5, 0.5). Codes round to nearest, values outside the range clamp.
+// Steps are powers of two, so decoding is exact up to the final add and every ISA
+// unpacks to the same floats. The eighth code is padding and always 0.
+static const float mixbox_packed_offset[MIXBOX_PACKED_LATENT_SIZE] = { -0.25f, -0.25f, -0.25f, -0.25f, -0.5f, -0.5f, -0.5f, 0.0f };
+static const float mixbox_packed_step[MIXBOX_PACKED_LATENT_SIZE] = { 0x1p-15f, 0x1p-15f, 0x1p-15f, 0x1p-15f, 0x1p-16f, 0x1p-16f, 0x1p-16f, 0.0f };
+
+INLINE static unsigned short pack_component(float x, int i)
+{
+  float q = (x - mixbox_packed_offset[i]) * (1.0f / mixbox_packed_step[i]);
+  q = q > 0.0f ? q : 0.0f;
+  q = q < 65535.0f ? q : 65535.0f;
+  return (unsigned short)(int)(q + 0.5f);
+}
+
+INLINE static float unpack_component(unsigned short q, int i)
+{
+  return float(q) * mixbox_packed_step[i] + mixbox_packed_offset[i];
+}
+
+void mixbox_pack_latent(mixbox_latent latent, mixbox_packed_latent out_packed)
+{
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { out_packed[i] = pack_component(latent[i], i); }
+  out_packed[MIXBOX_LATENT_SIZE] = 0;
+}
+
+void mixbox_unpack_latent(const mixbox_packed_latent packed, mixbox_latent out_latent)
+{
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { out_latent[i] = unpack_component(packed[i], i); }
+}
+
+// Batched kernels read and write planar latents: component i of pixel j lives at
+// latents_soa[i*stride + j]. Each block kernel converts a fixed number of pixels,
+// the n-wide drivers route the ragged tail through a zero-padded block so every
+// pixel of a row goes through the same arithmetic.
+
+template<int mode>
+static void float_rgb_to_latent_scalar(float r, float g, float b, mixbox_latent out_latent)
+{
+  float_rgb_to_latent<mode>(r, g, b, out_latent);
+}
+
+static void eval_polynomial_scalar(float c0, float c1, float c2, float c3, float* rgb)
+{
+  eval_polynomial(c0, c1, c2, c3, rgb);
+}
+
+static void lerp_latent_scalar(const float* latent1, const float* latent2, float t, float* out_latent)
+{
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    out_latent[i] = (1.0f-t)*latent1[i] + t*latent2[i];
+  }
+}
+
+template<int mode>
+static void rgb_to_latent_n_scalar(const unsigned char* rgb, size_t n, float* latents_soa)
+{
+  for (size_t j = 0; j < n; j++)
+  {
+    mixbox_latent latent;
+    float_rgb_to_latent<mode>(float(rgb[j*3 + 0]) / 255.0f, float(rgb[j*3 + 1]) / 255.0f, float(rgb[j*3 + 2]) / 255.0f, latent);
+    for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { latents_soa[i*n + j] = latent[i]; }
+  }
+}
+
+static void latent_to_rgb_n_scalar(const float* latents_soa, size_t n, unsigned char* rgb)
+{
+  for (size_t j = 0; j < n; j++)
+  {
+    float mixrgb[3];
+    eval_polynomial(latents_soa[0*n + j], latents_soa[1*n + j], latents_soa[2*n + j], latents_soa[3*n + j], mixrgb);
+    for (int c = 0; c < 3; c++)
+    {
+      rgb[j*3 + c] = (unsigned char)((int)(clamp01(mixrgb[c] + latents_soa[(4 + c)*n + j])*255.0f + 0.5f));
+    }
+  }
+}
+
+// Drives a block kernel of the given width over n pixels, padding the tail through a local block.
+template<int width, void (*block)(const unsigned char*, float*, size_t)>
+static void rgb_to_latent_n_blocked(const unsigned char* rgb, size_t n, float* latents_soa)
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width) { block(rgb + j*3, latents_soa + j, n); }
+  if (j == n) return;
+
+  unsigned char tail_rgb[width*3] = {0};
+  float tail_latents[MIXBOX_LATENT_SIZE*width];
+  memcpy(tail_rgb, rgb + j*3, (n - j)*3);
+  block(tail_rgb, tail_latents, width);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { memcpy(latents_soa + i*n + j, tail_latents + i*width, (n - j)*sizeof(float)); }
+}
+
+template<int width, void (*block)(const float*, size_t, unsigned char*)>
+static void latent_to_rgb_n_blocked(const float* latents_soa, size_t n, unsigned char* rgb)
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width) { block(latents_soa + j, n, rgb + j*3); }
+  if (j == n) return;
+
+  float tail_latents[MIXBOX_LATENT_SIZE*width] = {0};
+  unsigned char tail_rgb[width*3];
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { memcpy(tail_latents + i*width, latents_soa + i*n + j, (n - j)*sizeof(float)); }
+  block(tail_latents, width, tail_rgb);
+  memcpy(rgb + j*3, tail_rgb, (n - j)*3);
+}
+
+// Float variants apply an in-place transfer to the interleaved values of each block on
+// the way in or out, or none for plain sRGB.
+template<int width, void (*block)(const float*, float*, size_t)>
+static void float_rgb_to_latent_n_blocked(const float* rgb, size_t n, float* latents_soa, void (*transfer)(float*, size_t))
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width)
+  {
+    if (!transfer) { block(rgb + j*3, latents_soa + j, n); continue; }
+    float local_rgb[width*3];
+    memcpy(local_rgb, rgb + j*3, sizeof(local_rgb));
+    transfer(local_rgb, width*3);
+    block(local_rgb, latents_soa + j, n);
+  }
+  if (j == n) return;
+
+  float tail_rgb[width*3] = {0};
+  float tail_latents[MIXBOX_LATENT_SIZE*width];
+  memcpy(tail_rgb, rgb + j*3, (n - j)*3*sizeof(float));
+  if (transfer) transfer(tail_rgb, (n - j)*3);
+  block(tail_rgb, tail_latents, width);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { memcpy(latents_soa + i*n + j, tail_latents + i*width, (n - j)*sizeof(float)); }
+}
+
+template<int width, void (*block)(const float*, size_t, float*)>
+static void latent_to_float_rgb_n_blocked(const float* latents_soa, size_t n, float* rgb, void (*transfer)(float*, size_t))
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width)
+  {
+    block(latents_soa + j, n, rgb + j*3);
+    if (transfer) transfer(rgb + j*3, width*3);
+  }
+  if (j == n) return;
+
+  float tail_latents[MIXBOX_LATENT_SIZE*width] = {0};
+  float tail_rgb[width*3];
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { memcpy(tail_latents + i*width, latents_soa + i*n + j, (n - j)*sizeof(float)); }
+  block(tail_latents, width, tail_rgb);
+  if (transfer) transfer(tail_rgb, (n - j)*3);
+  memcpy(rgb + j*3, tail_rgb, (n - j)*3*sizeof(float));
+}
+
+template<int mode>
+static void float_rgb_to_latent_8_scalar(const float* rgb, float* latents_soa, size_t stride)
+{
+  for (int j = 0; j < 8; j++)
+  {
+    mixbox_latent latent;
+    float_rgb_to_latent<mode>(rgb[j*3 + 0], rgb[j*3 + 1], rgb[j*3 + 2], latent);
+    for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { latents_soa[i*stride + j] = latent[i]; }
+  }
+}
+
+static void latent_to_float_rgb_8_scalar(const float* latents_soa, size_t stride, float* rgb)
+{
+  for (int j = 0; j < 8; j++)
+  {
+    float mixrgb[3];
+    eval_polynomial(latents_soa[0*stride + j], latents_soa[1*stride + j], latents_soa[2*stride + j], latents_soa[3*stride + j], mixrgb);
+    for (int c = 0; c < 3; c++) { rgb[j*3 + c] = clamp01(mixrgb[c] + latents_soa[(4 + c)*stride + j]); }
+  }
+}
+
+static void srgb_to_linear_fast_n_scalar(float* values, size_t count)
+{
+  const float* const table = mixbox_transfer()->to_linear;
+  for (size_t i = 0; i < count; i++) { values[i] = transfer_lookup(table, values[i]); }
+}
+
+static void linear_to_srgb_fast_n_scalar(float* values, size_t count)
+{
+  const float* const table = mixbox_transfer()->to_srgb;
+  for (size_t i = 0; i < count; i++) { values[i] = transfer_lookup(table, values[i]); }
+}
+
+static void srgb_to_linear_exact_n(float* values, size_t count)
+{
+  for (size_t i = 0; i < count; i++) { values[i] = srgb_to_linear(values[i]); }
+}
+
+static void linear_to_srgb_exact_n(float* values, size_t count)
+{
+  for (size_t i = 0; i < count; i++) { values[i] = linear_to_srgb(values[i]); }
+}
+
+// The K-way mix blocks read pixel j+p of input i at images[i][(j+p)*3] with weight
+// weights[i*n + j+p], and write the block's pixels from out_rgb on.
+template<int width, void (*block)(const unsigned char* const*, const float*, int, size_t, size_t, unsigned char*)>
+static void mix_n_image_blocked(const unsigned char* const* images, const float* weights, int k, size_t n, unsigned char* out_rgb)
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width) { block(images, weights, k, n, j, out_rgb + j*3); }
+  if (j == n) return;
+
+  std::vector<unsigned char> tail_rgb(size_t(k)*width*3, 0);
+  std::vector<const unsigned char*> tail_images(k);
+  std::vector<float> tail_weights(size_t(k)*width, 0.0f);
+  for (int i = 0; i < k; i++)
+  {
+    memcpy(&tail_rgb[size_t(i)*width*3], images[i] + j*3, (n - j)*3);
+    memcpy(&tail_weights[size_t(i)*width], weights + size_t(i)*n + j, (n - j)*sizeof(float));
+    tail_images[i] = &tail_rgb[size_t(i)*width*3];
+  }
+  unsigned char tail_out[width*3];
+  block(tail_images.data(), tail_weights.data(), k, width, 0, tail_out);
+  memcpy(out_rgb + j*3, tail_out, (n - j)*3);
+}
+
+template<int mode>
+static void mix_n_8_scalar(const unsigned char* const* images, const float* weights, int k, size_t n, size_t j, unsigned char* out_rgb)
+{
+  for (int p = 0; p < 8; p++)
+  {
+    float mix[MIXBOX_LATENT_SIZE] = {0};
+    float sum = 0;
+    for (int i = 0; i < k; i++)
+    {
+      const unsigned char* const rgb = images[i] + (j + p)*3;
+      const float w = weights[size_t(i)*n + j + p];
+      mixbox_latent latent;
+      float_rgb_to_latent<mode>(float(rgb[0]) / 255.0f, float(rgb[1]) / 255.0f, float(rgb[2]) / 255.0f, latent);
+      for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] += w*latent[c]; }
+      sum += w;
+    }
+    const float norm = sum > 0.0f ? 1.0f / sum : 0.0f;
+    for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] *= norm; }
+
+    float mixrgb[3];
+    eval_polynomial(mix[0], mix[1], mix[2], mix[3], mixrgb);
+    for (int c = 0; c < 3; c++) { out_rgb[p*3 + c] = (unsigned char)((int)(clamp01(mixrgb[c] + mix[4 + c])*255.0f + 0.5f)); }
+  }
+}
+
+static void pack_latent_n_scalar(const float* latents_soa, size_t n, mixbox_packed_latent* packed)
+{
+  for (size_t j = 0; j < n; j++)
+  {
+    for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { packed[j][i] = pack_component(latents_soa[i*n + j], i); }
+    packed[j][MIXBOX_LATENT_SIZE] = 0;
+  }
+}
+
+static void unpack_latent_n_scalar(const mixbox_packed_latent* packed, size_t n, float* latents_soa)
+{
+  for (size_t j = 0; j < n; j++)
+  {
+    for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { latents_soa[i*n + j] = unpack_component(packed[j][i], i); }
+  }
+}
+
+// Packing blocks read planar latents and write whole packed latents, so the tail only
+// needs its planes padded on the way in or copied out on the way back.
+template<int width, void (*block)(const float*, size_t, mixbox_packed_latent*)>
+static void pack_latent_n_blocked(const float* latents_soa, size_t n, mixbox_packed_latent* packed)
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width) { block(latents_soa + j, n, packed + j); }
+  if (j == n) return;
+
+  float tail_latents[MIXBOX_LATENT_SIZE*width] = {0};
+  mixbox_packed_latent tail_packed[width];
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { memcpy(tail_latents + i*width, latents_soa + i*n + j, (n - j)*sizeof(float)); }
+  block(tail_latents, width, tail_packed);
+  memcpy(packed + j, tail_packed, (n - j)*sizeof(mixbox_packed_latent));
+}
+
+template<int width, void (*block)(const mixbox_packed_latent*, float*, size_t)>
+static void unpack_latent_n_blocked(const mixbox_packed_latent* packed, size_t n, float* latents_soa)
+{
+  size_t j = 0;
+  for (; j + width <= n; j += width) { block(packed + j, latents_soa + j, n); }
+  if (j == n) return;
+
+  mixbox_packed_latent tail_packed[width] = {};
+  float tail_latents[MIXBOX_LATENT_SIZE*width];
+  memcpy(tail_packed, packed + j, (n - j)*sizeof(mixbox_packed_latent));
+  block(tail_packed, tail_latents, width);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { memcpy(latents_soa + i*n + j, tail_latents + i*width, (n - j)*sizeof(float)); }
+}
+
+static const mixbox_kernels mixbox_kernels_scalar[MIXBOX_LUT_MODE_COUNT] =
+{
+#define MIXBOX_KERNELS(mode) \
+  { MIXBOX_ISA_SCALAR, mode, float_rgb_to_latent_scalar<mode>, eval_polynomial_scalar, lerp_latent_scalar, \
+    rgb_to_latent_n_scalar<mode>, latent_to_rgb_n_scalar, \
+    float_rgb_to_latent_n_blocked<8, float_rgb_to_latent_8_scalar<mode>>, latent_to_float_rgb_n_blocked<8, latent_to_float_rgb_8_scalar>, \
+    srgb_to_linear_fast_n_scalar, linear_to_srgb_fast_n_scalar, mix_n_image_blocked<8, mix_n_8_scalar<mode>>, \
+    pack_latent_n_scalar, unpack_latent_n_scalar },
+  MIXBOX_KERNELS(MIXBOX_LUT_TRILINEAR)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL_32)
+#undef MIXBOX_KERNELS
+};
+
+#ifdef MIXBOX_X86
+
+// Polynomial coefficients as (kr, kg, kb, 0) rows for the single-pixel evaluators.
+alignas(16) static const float mixbox_polynomial_rows[20][4] =
+{
+#define MIXBOX_TERM(x, y, kr, kg, kb) { kr, kg, kb, 0.0f },
+  MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+};
+
+// ---- SSE4.1 -------------------------------------------------------------------
+
+// One LUT tap for a single pixel: the three bytes at p widened to (c0, c1, c2, junk).
+MIXBOX_TARGET_SSE41 INLINE static __m128 lut_tap_sse41(const unsigned char* p)
+{
+  int word;
+  memcpy(&word, p, sizeof(word));
+  return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(word)));
+}
+
+// LUT fetch for one pixel already clamped to [0, 1], returns (c0, c1, c2, junk) scaled to [0, 1].
+template<int mode>
+MIXBOX_TARGET_SSE41 INLINE static __m128 lut_fetch_sse41(float r, float g, float b)
+{
+  __m128 acc;
+  if constexpr (mode == MIXBOX_LUT_TRILINEAR)
+  {
+    const float x = r * 63.0f;
+    const float y = g * 63.0f;
+    const float z = b * 63.0f;
+
+    const int ix = int(x);
+    const int iy = int(y);
+    const int iz = int(z);
+
+    const float tx = x - float(ix);
+    const float ty = y - float(iy);
+    const float tz = z - float(iz);
+
+    const unsigned char* const lut_ptr = &(mixbox_lut()[((ix + iy*64 + iz*64*64) & 0x3FFFF) * 3]);
+
+    acc =                  _mm_mul_ps(_mm_set1_ps((1.0f-tx)*(1.0f-ty)*(1.0f-tz)), lut_tap_sse41(lut_ptr +   192));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((     tx)*(1.0f-ty)*(1.0f-tz)), lut_tap_sse41(lut_ptr +   195)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((1.0f-tx)*(     ty)*(1.0f-tz)), lut_tap_sse41(lut_ptr +   384)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((     tx)*(     ty)*(1.0f-tz)), lut_tap_sse41(lut_ptr +   387)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((1.0f-tx)*(1.0f-ty)*(     tz)), lut_tap_sse41(lut_ptr + 12480)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((     tx)*(1.0f-ty)*(     tz)), lut_tap_sse41(lut_ptr + 12483)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((1.0f-tx)*(     ty)*(     tz)), lut_tap_sse41(lut_ptr + 12672)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps((     tx)*(     ty)*(     tz)), lut_tap_sse41(lut_ptr + 12675)));
+  }
+  else
+  {
+    const bool lut32 = (mode == MIXBOX_LUT_TETRAHEDRAL_32);
+    const float scale = lut32 ? 31.0f : 63.0f;
+
+    const float x = r * scale;
+    const float y = g * scale;
+    const float z = b * scale;
+
+    const int ix = lut32 ? (x < 31.0f ? int(x) : 30) : int(x);
+    const int iy = lut32 ? (y < 31.0f ? int(y) : 30) : int(y);
+    const int iz = lut32 ? (z < 31.0f ? int(z) : 30) : int(z);
+
+    const unsigned char* const lut_ptr = lut32 ? &(mixbox_lut32()[(ix + iy*32 + iz*32*32) * 4])
+                                               : &(mixbox_lut()[((ix + iy*64 + iz*64*64) & 0x3FFFF) * 3 + 192]);
+
+    int offset[4];
+    float weight[4];
+    tetrahedral_taps(x - float(ix), y - float(iy), z - float(iz),
+                     lut32 ? MIXBOX_LUT32_DX : MIXBOX_LUT64_DX,
+                     lut32 ? MIXBOX_LUT32_DY : MIXBOX_LUT64_DY,
+                     lut32 ? MIXBOX_LUT32_DZ : MIXBOX_LUT64_DZ, offset, weight);
+
+    acc =                  _mm_mul_ps(_mm_set1_ps(weight[0]), lut_tap_sse41(lut_ptr + offset[0]));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[1]), lut_tap_sse41(lut_ptr + offset[1])));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[2]), lut_tap_sse41(lut_ptr + offset[2])));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[3]), lut_tap_sse41(lut_ptr + offset[3])));
+  }
+  return _mm_mul_ps(acc, _mm_set1_ps(1.0f / 255.0f));
+}
+
+MIXBOX_TARGET_SSE41 static void eval_polynomial_sse41(float c0, float c1, float c2, float c3, float* rgb)
+{
+  const float c00 = c0 * c0;
+  const float c11 = c1 * c1;
+  const float c22 = c2 * c2;
+  const float c33 = c3 * c3;
+  const float c01 = c0 * c1;
+  const float c02 = c0 * c2;
+  const float c12 = c1 * c2;
+
+  const float w[20] =
+  {
+#define MIXBOX_TERM(x, y, kr, kg, kb) x*y,
+    MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+  };
+
+  __m128 acc = _mm_setzero_ps();
+  for (int i = 0; i < 20; i++) { acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(mixbox_polynomial_rows[i]), _mm_set1_ps(w[i]))); }
+
+  alignas(16) float out[4];
+  _mm_store_ps(out, acc);
+  rgb[0] = out[0];
+  rgb[1] = out[1];
+  rgb[2] = out[2];
+}
+
+template<int mode>
+MIXBOX_TARGET_SSE41 static void float_rgb_to_latent_sse41(float r, float g, float b, mixbox_latent out_latent)
+{
+  r = clamp01(r);
+  g = clamp01(g);
+  b = clamp01(b);
+
+  alignas(16) float c[4];
+  _mm_store_ps(c, lut_fetch_sse41<mode>(r, g, b));
+
+  const float c3 = 1.0f - (c[0] + c[1] + c[2]);
+
+  float mixrgb[3];
+  eval_polynomial_sse41(c[0], c[1], c[2], c3, mixrgb);
+
+  out_latent[0] = c[0];
+  out_latent[1] = c[1];
+  out_latent[2] = c[2];
+  out_latent[3] = c3;
+  out_latent[4] = r - mixrgb[0];
+  out_latent[5] = g - mixrgb[1];
+  out_latent[6] = b - mixrgb[2];
+}
+
+// The latent is 7 floats: lerp lanes 0-3 and 3-6, the shared lane 3 is written twice with the same value.
+MIXBOX_TARGET_SSE41 static void lerp_latent_sse41(const float* latent1, const float* latent2, float t, float* out_latent)
+{
+  const __m128 s = _mm_set1_ps(1.0f - t);
+  const __m128 u = _mm_set1_ps(t);
+  const __m128 lo = _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(latent1)), _mm_mul_ps(u, _mm_loadu_ps(latent2)));
+  const __m128 hi = _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(latent1 + 3)), _mm_mul_ps(u, _mm_loadu_ps(latent2 + 3)));
+  _mm_storeu_ps(out_latent, lo);
+  _mm_storeu_ps(out_latent + 3, hi);
+}
+
+MIXBOX_TARGET_SSE41 INLINE static void eval_polynomial_4_sse41(__m128 c0, __m128 c1, __m128 c2, __m128 c3, __m128* out_r, __m128* out_g, __m128* out_b)
+{
+  const __m128 c00 = _mm_mul_ps(c0, c0);
+  const __m128 c11 = _mm_mul_ps(c1, c1);
+  const __m128 c22 = _mm_mul_ps(c2, c2);
+  const __m128 c33 = _mm_mul_ps(c3, c3);
+  const __m128 c01 = _mm_mul_ps(c0, c1);
+  const __m128 c02 = _mm_mul_ps(c0, c2);
+  const __m128 c12 = _mm_mul_ps(c1, c2);
+
+  __m128 r = _mm_setzero_ps();
+  __m128 g = _mm_setzero_ps();
+  __m128 b = _mm_setzero_ps();
+
+  __m128 w;
+#define MIXBOX_TERM(x, y, kr, kg, kb) \
+  w = _mm_mul_ps(x, y); \
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(kr), w)); \
+  g = _mm_add_ps(g, _mm_mul_ps(_mm_set1_ps(kg), w)); \
+  b = _mm_add_ps(b, _mm_mul_ps(_mm_set1_ps(kb), w));
+  MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+
+  *out_r = r;
+  *out_g = g;
+  *out_b = b;
+}
+
+// Converts 4 pixels. SSE4.1 has no gather, so the LUT taps are fetched per pixel
+// as (c0, c1, c2, junk) vectors and transposed into planes for the polynomial.
+template<int mode>
+MIXBOX_TARGET_SSE41 INLINE static void float_rgb_to_latent_4_sse41(__m128 r, __m128 g, __m128 b, __m128* latent)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  r = _mm_min_ps(_mm_max_ps(r, zero), one);
+  g = _mm_min_ps(_mm_max_ps(g, zero), one);
+  b = _mm_min_ps(_mm_max_ps(b, zero), one);
+
+  alignas(16) float rgb[3][4];
+  _mm_store_ps(rgb[0], r);
+  _mm_store_ps(rgb[1], g);
+  _mm_store_ps(rgb[2], b);
+
+  __m128 c[4];
+  for (int lane = 0; lane < 4; lane++) { c[lane] = lut_fetch_sse41<mode>(rgb[0][lane], rgb[1][lane], rgb[2][lane]); }
+  _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+
+  const __m128 c3 = _mm_sub_ps(one, _mm_add_ps(_mm_add_ps(c[0], c[1]), c[2]));
+
+  __m128 mix_r, mix_g, mix_b;
+  eval_polynomial_4_sse41(c[0], c[1], c[2], c3, &mix_r, &mix_g, &mix_b);
+
+  latent[0] = c[0];
+  latent[1] = c[1];
+  latent[2] = c[2];
+  latent[3] = c3;
+  latent[4] = _mm_sub_ps(r, mix_r);
+  latent[5] = _mm_sub_ps(g, mix_g);
+  latent[6] = _mm_sub_ps(b, mix_b);
+}
+
+template<int mode>
+MIXBOX_TARGET_SSE41 INLINE static void float_rgb_to_latent_4_sse41(__m128 r, __m128 g, __m128 b, float* latents_soa, size_t stride)
+{
+  __m128 latent[MIXBOX_LATENT_SIZE];
+  float_rgb_to_latent_4_sse41<mode>(r, g, b, latent);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { _mm_storeu_ps(latents_soa + i*stride, latent[i]); }
+}
+
+template<int mode>
+MIXBOX_TARGET_SSE41 static void rgb_to_latent_8_sse41(const unsigned char* rgb, float* latents_soa, size_t stride)
+{
+  const __m128 scale = _mm_set1_ps(255.0f);
+  for (int half = 0; half < 8; half += 4)
+  {
+    const unsigned char* p = rgb + half*3;
+    const __m128 r = _mm_div_ps(_mm_setr_ps(p[0], p[3], p[6], p[ 9]), scale);
+    const __m128 g = _mm_div_ps(_mm_setr_ps(p[1], p[4], p[7], p[10]), scale);
+    const __m128 b = _mm_div_ps(_mm_setr_ps(p[2], p[5], p[8], p[11]), scale);
+    float_rgb_to_latent_4_sse41<mode>(r, g, b, latents_soa + half, stride);
+  }
+}
+
+MIXBOX_TARGET_SSE41 static void latent_to_rgb_8_sse41(const float* latents_soa, size_t stride, unsigned char* rgb)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+
+  for (int h = 0; h < 8; h += 4)
+  {
+    const float* l = latents_soa + h;
+    __m128 r, g, b;
+    eval_polynomial_4_sse41(_mm_loadu_ps(l + 0*stride), _mm_loadu_ps(l + 1*stride),
+                            _mm_loadu_ps(l + 2*stride), _mm_loadu_ps(l + 3*stride), &r, &g, &b);
+    r = _mm_min_ps(_mm_max_ps(_mm_add_ps(r, _mm_loadu_ps(l + 4*stride)), zero), one);
+    g = _mm_min_ps(_mm_max_ps(_mm_add_ps(g, _mm_loadu_ps(l + 5*stride)), zero), one);
+    b = _mm_min_ps(_mm_max_ps(_mm_add_ps(b, _mm_loadu_ps(l + 6*stride)), zero), one);
+
+    alignas(16) int out[3][4];
+    _mm_store_si128((__m128i*)out[0], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half)));
+    _mm_store_si128((__m128i*)out[1], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half)));
+    _mm_store_si128((__m128i*)out[2], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half)));
+    for (int j = 0; j < 4; j++)
+    {
+      rgb[(h + j)*3 + 0] = (unsigned char)out[0][j];
+      rgb[(h + j)*3 + 1] = (unsigned char)out[1][j];
+      rgb[(h + j)*3 + 2] = (unsigned char)out[2][j];
+    }
+  }
+}
+
+template<int mode>
+MIXBOX_TARGET_SSE41 static void float_rgb_to_latent_8_sse41(const float* rgb, float* latents_soa, size_t stride)
+{
+  for (int half = 0; half < 8; half += 4)
+  {
+    const float* p = rgb + half*3;
+    float_rgb_to_latent_4_sse41<mode>(_mm_setr_ps(p[0], p[3], p[6], p[ 9]),
+                                      _mm_setr_ps(p[1], p[4], p[7], p[10]),
+                                      _mm_setr_ps(p[2], p[5], p[8], p[11]), latents_soa + half, stride);
+  }
+}
+
+MIXBOX_TARGET_SSE41 static void latent_to_float_rgb_8_sse41(const float* latents_soa, size_t stride, float* rgb)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  for (int h = 0; h < 8; h += 4)
+  {
+    const float* l = latents_soa + h;
+    __m128 r, g, b;
+    eval_polynomial_4_sse41(_mm_loadu_ps(l + 0*stride), _mm_loadu_ps(l + 1*stride),
+                            _mm_loadu_ps(l + 2*stride), _mm_loadu_ps(l + 3*stride), &r, &g, &b);
+    r = _mm_min_ps(_mm_max_ps(_mm_add_ps(r, _mm_loadu_ps(l + 4*stride)), zero), one);
+    g = _mm_min_ps(_mm_max_ps(_mm_add_ps(g, _mm_loadu_ps(l + 5*stride)), zero), one);
+    b = _mm_min_ps(_mm_max_ps(_mm_add_ps(b, _mm_loadu_ps(l + 6*stride)), zero), one);
+
+    // transpose to one (r, g, b, 0) vector per pixel, each store's 4th lane is overwritten by the next pixel
+    __m128 p0 = r, p1 = g, p2 = b, p3 = zero;
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+    float* out = rgb + h*3;
+    _mm_storeu_ps(out + 0, p0);
+    _mm_storeu_ps(out + 3, p1);
+    _mm_storeu_ps(out + 6, p2);
+    out[ 9] = _mm_cvtss_f32(p3);
+    out[10] = _mm_cvtss_f32(_mm_shuffle_ps(p3, p3, 1));
+    out[11] = _mm_cvtss_f32(_mm_shuffle_ps(p3, p3, 2));
+  }
+}
+
+// Each input's latent is weighted into the accumulators as soon as it is converted,
+// so per input only its rgb bytes and weights are read from memory.
+template<int mode>
+MIXBOX_TARGET_SSE41 static void mix_n_8_sse41(const unsigned char* const* images, const float* weights, int k, size_t n, size_t j, unsigned char* out_rgb)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+
+  for (int h = 0; h < 8; h += 4)
+  {
+    __m128 mix[MIXBOX_LATENT_SIZE];
+    for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = zero; }
+    __m128 sum = zero;
+
+    for (int i = 0; i < k; i++)
+    {
+      const unsigned char* p = images[i] + (j + h)*3;
+      __m128 latent[MIXBOX_LATENT_SIZE];
+      float_rgb_to_latent_4_sse41<mode>(_mm_div_ps(_mm_setr_ps(p[0], p[3], p[6], p[ 9]), scale),
+                                        _mm_div_ps(_mm_setr_ps(p[1], p[4], p[7], p[10]), scale),
+                                        _mm_div_ps(_mm_setr_ps(p[2], p[5], p[8], p[11]), scale), latent);
+      const __m128 w = _mm_loadu_ps(weights + size_t(i)*n + j + h);
+      for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = _mm_add_ps(mix[c], _mm_mul_ps(w, latent[c])); }
+      sum = _mm_add_ps(sum, w);
+    }
+
+    const __m128 norm = _mm_and_ps(_mm_div_ps(one, sum), _mm_cmpgt_ps(sum, zero));
+    for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = _mm_mul_ps(mix[c], norm); }
+
+    __m128 r, g, b;
+    eval_polynomial_4_sse41(mix[0], mix[1], mix[2], mix[3], &r, &g, &b);
+    r = _mm_min_ps(_mm_max_ps(_mm_add_ps(r, mix[4]), zero), one);
+    g = _mm_min_ps(_mm_max_ps(_mm_add_ps(g, mix[5]), zero), one);
+    b = _mm_min_ps(_mm_max_ps(_mm_add_ps(b, mix[6]), zero), one);
+
+    alignas(16) int out[3][4];
+    _mm_store_si128((__m128i*)out[0], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half)));
+    _mm_store_si128((__m128i*)out[1], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half)));
+    _mm_store_si128((__m128i*)out[2], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half)));
+    for (int q = 0; q < 4; q++)
+    {
+      out_rgb[(h + q)*3 + 0] = (unsigned char)out[0][q];
+      out_rgb[(h + q)*3 + 1] = (unsigned char)out[1][q];
+      out_rgb[(h + q)*3 + 2] = (unsigned char)out[2][q];
+    }
+  }
+}
+
+// Transposes 8 rows of 8 16-bit values, turning 8 component rows into 8 packed latents and back.
+MIXBOX_TARGET_SSE41 INLINE static void transpose_8x8_epi16_sse41(__m128i* v)
+{
+  const __m128i a0 = _mm_unpacklo_epi16(v[0], v[1]);
+  const __m128i a1 = _mm_unpackhi_epi16(v[0], v[1]);
+  const __m128i a2 = _mm_unpacklo_epi16(v[2], v[3]);
+  const __m128i a3 = _mm_unpackhi_epi16(v[2], v[3]);
+  const __m128i a4 = _mm_unpacklo_epi16(v[4], v[5]);
+  const __m128i a5 = _mm_unpackhi_epi16(v[4], v[5]);
+  const __m128i a6 = _mm_unpacklo_epi16(v[6], v[7]);
+  const __m128i a7 = _mm_unpackhi_epi16(v[6], v[7]);
+
+  const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+  v[0] = _mm_unpacklo_epi64(b0, b4);
+  v[1] = _mm_unpackhi_epi64(b0, b4);
+  v[2] = _mm_unpacklo_epi64(b1, b5);
+  v[3] = _mm_unpackhi_epi64(b1, b5);
+  v[4] = _mm_unpacklo_epi64(b2, b6);
+  v[5] = _mm_unpackhi_epi64(b2, b6);
+  v[6] = _mm_unpacklo_epi64(b3, b7);
+  v[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// Same rounding as pack_component: scale, clamp to [0, 65535], add a half and truncate.
+MIXBOX_TARGET_SSE41 INLINE static __m128i pack_component_4_sse41(__m128 x, int i)
+{
+  const __m128 q = _mm_mul_ps(_mm_sub_ps(x, _mm_set1_ps(mixbox_packed_offset[i])), _mm_set1_ps(1.0f / mixbox_packed_step[i]));
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), _mm_set1_ps(65535.0f)), _mm_set1_ps(0.5f)));
+}
+
+MIXBOX_TARGET_SSE41 static void pack_latent_8_sse41(const float* latents_soa, size_t stride, mixbox_packed_latent* packed)
+{
+  __m128i v[8];
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    v[i] = _mm_packus_epi32(pack_component_4_sse41(_mm_loadu_ps(latents_soa + i*stride + 0), i),
+                            pack_component_4_sse41(_mm_loadu_ps(latents_soa + i*stride + 4), i));
+  }
+  v[7] = _mm_setzero_si128();
+  transpose_8x8_epi16_sse41(v);
+  for (int j = 0; j < 8; j++) { _mm_storeu_si128((__m128i*)packed[j], v[j]); }
+}
+
+MIXBOX_TARGET_SSE41 static void unpack_latent_8_sse41(const mixbox_packed_latent* packed, float* latents_soa, size_t stride)
+{
+  __m128i v[8];
+  for (int j = 0; j < 8; j++) { v[j] = _mm_loadu_si128((const __m128i*)packed[j]); }
+  transpose_8x8_epi16_sse41(v);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    const __m128 scale = _mm_set1_ps(mixbox_packed_step[i]);
+    const __m128 offset = _mm_set1_ps(mixbox_packed_offset[i]);
+    _mm_storeu_ps(latents_soa + i*stride + 0, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(v[i])), scale), offset));
+    _mm_storeu_ps(latents_soa + i*stride + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v[i], 8))), scale), offset));
+  }
+}
+
+static const mixbox_kernels mixbox_kernels_sse41[MIXBOX_LUT_MODE_COUNT] =
+{
+#define MIXBOX_KERNELS(mode) \
+  { MIXBOX_ISA_SSE41, mode, float_rgb_to_latent_sse41<mode>, eval_polynomial_sse41, lerp_latent_sse41, \
+    rgb_to_latent_n_blocked<8, rgb_to_latent_8_sse41<mode>>, latent_to_rgb_n_blocked<8, latent_to_rgb_8_sse41>, \
+    float_rgb_to_latent_n_blocked<8, float_rgb_to_latent_8_sse41<mode>>, latent_to_float_rgb_n_blocked<8, latent_to_float_rgb_8_sse41>, \
+    srgb_to_linear_fast_n_scalar, linear_to_srgb_fast_n_scalar, mix_n_image_blocked<8, mix_n_8_sse41<mode>>, \
+    pack_latent_n_blocked<8, pack_latent_8_sse41>, unpack_latent_n_blocked<8, unpack_latent_8_sse41> },
+  MIXBOX_KERNELS(MIXBOX_LUT_TRILINEAR)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL_32)
+#undef MIXBOX_KERNELS
+};
+
+// ---- AVX2 + FMA ---------------------------------------------------------------
+
+MIXBOX_TARGET_AVX2 static void eval_polynomial_avx2(float c0, float c1, float c2, float c3, float* rgb)
+{
+  const float c00 = c0 * c0;
+  const float c11 = c1 * c1;
+  const float c22 = c2 * c2;
+  const float c33 = c3 * c3;
+  const float c01 = c0 * c1;
+  const float c02 = c0 * c2;
+  const float c12 = c1 * c2;
+
+  const float w[20] =
+  {
+#define MIXBOX_TERM(x, y, kr, kg, kb) x*y,
+    MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+  };
+
+  __m128 acc = _mm_setzero_ps();
+  for (int i = 0; i < 20; i++) { acc = _mm_fmadd_ps(_mm_load_ps(mixbox_polynomial_rows[i]), _mm_set1_ps(w[i]), acc); }
+
+  alignas(16) float out[4];
+  _mm_store_ps(out, acc);
+  rgb[0] = out[0];
+  rgb[1] = out[1];
+  rgb[2] = out[2];
+}
+
+template<int mode>
+MIXBOX_TARGET_AVX2 static void float_rgb_to_latent_avx2(float r, float g, float b, mixbox_latent out_latent)
+{
+  r = clamp01(r);
+  g = clamp01(g);
+  b = clamp01(b);
+
+  alignas(16) float c[4];
+  _mm_store_ps(c, lut_fetch_sse41<mode>(r, g, b));
+
+  const float c3 = 1.0f - (c[0] + c[1] + c[2]);
+
+  float mixrgb[3];
+  eval_polynomial_avx2(c[0], c[1], c[2], c3, mixrgb);
+
+  out_latent[0] = c[0];
+  out_latent[1] = c[1];
+  out_latent[2] = c[2];
+  out_latent[3] = c3;
+  out_latent[4] = r - mixrgb[0];
+  out_latent[5] = g - mixrgb[1];
+  out_latent[6] = b - mixrgb[2];
+}
+
+MIXBOX_TARGET_AVX2 static void lerp_latent_avx2(const float* latent1, const float* latent2, float t, float* out_latent)
+{
+  const __m256i mask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, -1, 0);
+  const __m256 l1 = _mm256_maskload_ps(latent1, mask);
+  const __m256 l2 = _mm256_maskload_ps(latent2, mask);
+  _mm256_maskstore_ps(out_latent, mask, _mm256_fmadd_ps(_mm256_set1_ps(t), l2, _mm256_mul_ps(_mm256_set1_ps(1.0f - t), l1)));
+}
+
+MIXBOX_TARGET_AVX2 INLINE static void eval_polynomial_8_avx2(__m256 c0, __m256 c1, __m256 c2, __m256 c3, __m256* out_r, __m256* out_g, __m256* out_b)
+{
+  const __m256 c00 = _mm256_mul_ps(c0, c0);
+  const __m256 c11 = _mm256_mul_ps(c1, c1);
+  const __m256 c22 = _mm256_mul_ps(c2, c2);
+  const __m256 c33 = _mm256_mul_ps(c3, c3);
+  const __m256 c01 = _mm256_mul_ps(c0, c1);
+  const __m256 c02 = _mm256_mul_ps(c0, c2);
+  const __m256 c12 = _mm256_mul_ps(c1, c2);
+
+  __m256 r = _mm256_setzero_ps();
+  __m256 g = _mm256_setzero_ps();
+  __m256 b = _mm256_setzero_ps();
+
+  __m256 w;
+#define MIXBOX_TERM(x, y, kr, kg, kb) \
+  w = _mm256_mul_ps(x, y); \
+  r = _mm256_fmadd_ps(_mm256_set1_ps(kr), w, r); \
+  g = _mm256_fmadd_ps(_mm256_set1_ps(kg), w, g); \
+  b = _mm256_fmadd_ps(_mm256_set1_ps(kb), w, b);
+  MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+
+  *out_r = r;
+  *out_g = g;
+  *out_b = b;
+}
+
+// Eight LUT taps at once: every lane gathers the 32-bit word starting at its entry
+// and keeps the low three bytes as (c0, c1, c2).
+MIXBOX_TARGET_AVX2 INLINE static void lut_tap_8_avx2(const unsigned char* p, __m256i idx, __m256 w, __m256* c0, __m256* c1, __m256* c2)
+{
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  const __m256i v = _mm256_i32gather_epi32((const int*)p, idx, 1);
+  *c0 = _mm256_fmadd_ps(w, _mm256_cvtepi32_ps(_mm256_and_si256(v, mask)), *c0);
+  *c1 = _mm256_fmadd_ps(w, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask)), *c1);
+  *c2 = _mm256_fmadd_ps(w, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask)), *c2);
+}
+
+// LUT fetch for eight pixels already clamped to [0, 1], the (c0, c1, c2) planes come back scaled to [0, 1].
+// The tetrahedral modes pick each lane's tetrahedron with compares and blends instead of branches.
+template<int mode>
+MIXBOX_TARGET_AVX2 INLINE static void lut_fetch_8_avx2(__m256 r, __m256 g, __m256 b, __m256* out_c0, __m256* out_c1, __m256* out_c2)
+{
+  const bool lut32 = (mode == MIXBOX_LUT_TETRAHEDRAL_32);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 scale = _mm256_set1_ps(lut32 ? 31.0f : 63.0f);
+
+  const __m256 x = _mm256_mul_ps(r, scale);
+  const __m256 y = _mm256_mul_ps(g, scale);
+  const __m256 z = _mm256_mul_ps(b, scale);
+
+  __m256i ix = _mm256_cvttps_epi32(x);
+  __m256i iy = _mm256_cvttps_epi32(y);
+  __m256i iz = _mm256_cvttps_epi32(z);
+  if (lut32)
+  {
+    ix = _mm256_min_epi32(ix, _mm256_set1_epi32(30));
+    iy = _mm256_min_epi32(iy, _mm256_set1_epi32(30));
+    iz = _mm256_min_epi32(iz, _mm256_set1_epi32(30));
+  }
+
+  const __m256 tx = _mm256_sub_ps(x, _mm256_cvtepi32_ps(ix));
+  const __m256 ty = _mm256_sub_ps(y, _mm256_cvtepi32_ps(iy));
+  const __m256 tz = _mm256_sub_ps(z, _mm256_cvtepi32_ps(iz));
+
+  __m256i idx;
+  if (lut32)
+  {
+    idx = _mm256_add_epi32(ix, _mm256_add_epi32(_mm256_slli_epi32(iy, 5), _mm256_slli_epi32(iz, 10)));
+    idx = _mm256_slli_epi32(idx, 2);
+  }
+  else
+  {
+    idx = _mm256_add_epi32(ix, _mm256_add_epi32(_mm256_slli_epi32(iy, 6), _mm256_slli_epi32(iz, 12)));
+    idx = _mm256_and_si256(idx, _mm256_set1_epi32(0x3FFFF));
+    idx = _mm256_add_epi32(idx, _mm256_add_epi32(idx, idx));
+  }
+
+  __m256 c0 = _mm256_setzero_ps();
+  __m256 c1 = _mm256_setzero_ps();
+  __m256 c2 = _mm256_setzero_ps();
+
+  if constexpr (mode == MIXBOX_LUT_TRILINEAR)
+  {
+    const __m256 sx = _mm256_sub_ps(one, tx);
+    const __m256 sy = _mm256_sub_ps(one, ty);
+    const __m256 sz = _mm256_sub_ps(one, tz);
+
+    const unsigned char* const lut = mixbox_lut();
+    lut_tap_8_avx2(lut +   192, idx, _mm256_mul_ps(_mm256_mul_ps(sx, sy), sz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut +   195, idx, _mm256_mul_ps(_mm256_mul_ps(tx, sy), sz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut +   384, idx, _mm256_mul_ps(_mm256_mul_ps(sx, ty), sz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut +   387, idx, _mm256_mul_ps(_mm256_mul_ps(tx, ty), sz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut + 12480, idx, _mm256_mul_ps(_mm256_mul_ps(sx, sy), tz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut + 12483, idx, _mm256_mul_ps(_mm256_mul_ps(tx, sy), tz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut + 12672, idx, _mm256_mul_ps(_mm256_mul_ps(sx, ty), tz), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut + 12675, idx, _mm256_mul_ps(_mm256_mul_ps(tx, ty), tz), &c0, &c1, &c2);
+  }
+  else
+  {
+    const __m256 dx = _mm256_castsi256_ps(_mm256_set1_epi32(lut32 ? MIXBOX_LUT32_DX : MIXBOX_LUT64_DX));
+    const __m256 dy = _mm256_castsi256_ps(_mm256_set1_epi32(lut32 ? MIXBOX_LUT32_DY : MIXBOX_LUT64_DY));
+    const __m256 dz = _mm256_castsi256_ps(_mm256_set1_epi32(lut32 ? MIXBOX_LUT32_DZ : MIXBOX_LUT64_DZ));
+    const __m256i dxyz = _mm256_set1_epi32(lut32 ? MIXBOX_LUT32_DX + MIXBOX_LUT32_DY + MIXBOX_LUT32_DZ
+                                                 : MIXBOX_LUT64_DX + MIXBOX_LUT64_DY + MIXBOX_LUT64_DZ);
+
+    // same selection as tetrahedral_taps, lane by lane
+    const __m256 x_max = _mm256_and_ps(_mm256_cmp_ps(tx, ty, _CMP_GE_OQ), _mm256_cmp_ps(tx, tz, _CMP_GE_OQ));
+    const __m256 y_max = _mm256_andnot_ps(x_max, _mm256_cmp_ps(ty, tz, _CMP_GE_OQ));
+    const __m256 z_min = _mm256_and_ps(_mm256_cmp_ps(tz, ty, _CMP_LE_OQ), _mm256_cmp_ps(tz, tx, _CMP_LE_OQ));
+    const __m256 y_min = _mm256_andnot_ps(z_min, _mm256_and_ps(_mm256_cmp_ps(ty, tx, _CMP_LE_OQ), _mm256_cmp_ps(ty, tz, _CMP_LE_OQ)));
+
+    const __m256 t_max = _mm256_blendv_ps(_mm256_blendv_ps(tz, ty, y_max), tx, x_max);
+    const __m256 t_min = _mm256_blendv_ps(_mm256_blendv_ps(tx, ty, y_min), tz, z_min);
+    const __m256 t_mid = _mm256_max_ps(_mm256_min_ps(tx, ty), _mm256_min_ps(_mm256_max_ps(tx, ty), tz));
+
+    const __m256i step_max = _mm256_castps_si256(_mm256_blendv_ps(_mm256_blendv_ps(dz, dy, y_max), dx, x_max));
+    const __m256i step_min = _mm256_castps_si256(_mm256_blendv_ps(_mm256_blendv_ps(dx, dy, y_min), dz, z_min));
+
+    const unsigned char* const lut = lut32 ? mixbox_lut32() : mixbox_lut() + 192;
+    lut_tap_8_avx2(lut, idx, _mm256_sub_ps(one, t_max), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut, _mm256_add_epi32(idx, step_max), _mm256_sub_ps(t_max, t_mid), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut, _mm256_add_epi32(idx, _mm256_sub_epi32(dxyz, step_min)), _mm256_sub_ps(t_mid, t_min), &c0, &c1, &c2);
+    lut_tap_8_avx2(lut, _mm256_add_epi32(idx, dxyz), t_min, &c0, &c1, &c2);
+  }
+
+  const __m256 inv255 = _mm256_set1_ps(1.0f / 255.0f);
+  *out_c0 = _mm256_mul_ps(c0, inv255);
+  *out_c1 = _mm256_mul_ps(c1, inv255);
+  *out_c2 = _mm256_mul_ps(c2, inv255);
+}
+
+template<int mode>
+MIXBOX_TARGET_AVX2 INLINE static void float_rgb_to_latent_8_avx2(__m256 r, __m256 g, __m256 b, __m256* latent)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  r = _mm256_min_ps(_mm256_max_ps(r, zero), one);
+  g = _mm256_min_ps(_mm256_max_ps(g, zero), one);
+  b = _mm256_min_ps(_mm256_max_ps(b, zero), one);
+
+  __m256 c0, c1, c2;
+  lut_fetch_8_avx2<mode>(r, g, b, &c0, &c1, &c2);
+  const __m256 c3 = _mm256_sub_ps(one, _mm256_add_ps(_mm256_add_ps(c0, c1), c2));
+
+  __m256 mix_r, mix_g, mix_b;
+  eval_polynomial_8_avx2(c0, c1, c2, c3, &mix_r, &mix_g, &mix_b);
+
+  latent[0] = c0;
+  latent[1] = c1;
+  latent[2] = c2;
+  latent[3] = c3;
+  latent[4] = _mm256_sub_ps(r, mix_r);
+  latent[5] = _mm256_sub_ps(g, mix_g);
+  latent[6] = _mm256_sub_ps(b, mix_b);
+}
+
+template<int mode>
+MIXBOX_TARGET_AVX2 INLINE static void float_rgb_to_latent_8_avx2(__m256 r, __m256 g, __m256 b, float* latents_soa, size_t stride)
+{
+  __m256 latent[MIXBOX_LATENT_SIZE];
+  float_rgb_to_latent_8_avx2<mode>(r, g, b, latent);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { _mm256_storeu_ps(latents_soa + i*stride, latent[i]); }
+}
+
+// Deinterleaves 8 packed rgb pixels (24 bytes) into three planes of floats in [0, 1].
+MIXBOX_TARGET_AVX2 INLINE static void load_rgb_8_avx2(const unsigned char* rgb, __m256* r, __m256* g, __m256* b)
+{
+  const __m128i lo = _mm_loadu_si128((const __m128i*)rgb);
+  const __m128i hi = _mm_loadl_epi64((const __m128i*)(rgb + 16));
+
+  const __m128i r_lo = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i r_hi = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i g_lo = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i g_hi = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i b_lo = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i b_hi = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+  const __m256 scale = _mm256_set1_ps(255.0f);
+  *r = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, r_lo), _mm_shuffle_epi8(hi, r_hi)))), scale);
+  *g = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, g_lo), _mm_shuffle_epi8(hi, g_hi)))), scale);
+  *b = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, b_lo), _mm_shuffle_epi8(hi, b_hi)))), scale);
+}
+
+MIXBOX_TARGET_AVX2 INLINE static void store_rgb_8_avx2(__m256 r, __m256 g, __m256 b, unsigned char* rgb)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 scale = _mm256_set1_ps(255.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+
+  alignas(32) int out[3][8];
+  _mm256_store_si256((__m256i*)out[0], _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_min_ps(_mm256_max_ps(r, zero), one), scale, half)));
+  _mm256_store_si256((__m256i*)out[1], _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_min_ps(_mm256_max_ps(g, zero), one), scale, half)));
+  _mm256_store_si256((__m256i*)out[2], _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_min_ps(_mm256_max_ps(b, zero), one), scale, half)));
+  for (int j = 0; j < 8; j++)
+  {
+    rgb[j*3 + 0] = (unsigned char)out[0][j];
+    rgb[j*3 + 1] = (unsigned char)out[1][j];
+    rgb[j*3 + 2] = (unsigned char)out[2][j];
+  }
+}
+
+template<int mode>
+MIXBOX_TARGET_AVX2 static void rgb_to_latent_8_avx2(const unsigned char* rgb, float* latents_soa, size_t stride)
+{
+  __m256 r, g, b;
+  load_rgb_8_avx2(rgb, &r, &g, &b);
+  float_rgb_to_latent_8_avx2<mode>(r, g, b, latents_soa, stride);
+}
+
+MIXBOX_TARGET_AVX2 static void latent_to_rgb_8_avx2(const float* latents_soa, size_t stride, unsigned char* rgb)
+{
+  __m256 r, g, b;
+  eval_polynomial_8_avx2(_mm256_loadu_ps(latents_soa + 0*stride), _mm256_loadu_ps(latents_soa + 1*stride),
+                         _mm256_loadu_ps(latents_soa + 2*stride), _mm256_loadu_ps(latents_soa + 3*stride), &r, &g, &b);
+  store_rgb_8_avx2(_mm256_add_ps(r, _mm256_loadu_ps(latents_soa + 4*stride)),
+                   _mm256_add_ps(g, _mm256_loadu_ps(latents_soa + 5*stride)),
+                   _mm256_add_ps(b, _mm256_loadu_ps(latents_soa + 6*stride)), rgb);
+}
+
+// Deinterleaves 8 packed float rgb pixels (24 floats) with one gather per channel.
+MIXBOX_TARGET_AVX2 INLINE static void load_float_rgb_8_avx2(const float* rgb, __m256* r, __m256* g, __m256* b)
+{
+  const __m256i idx = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  *r = _mm256_i32gather_ps(rgb + 0, idx, 4);
+  *g = _mm256_i32gather_ps(rgb + 1, idx, 4);
+  *b = _mm256_i32gather_ps(rgb + 2, idx, 4);
+}
+
+MIXBOX_TARGET_AVX2 INLINE static void store_float_rgb_8_avx2(__m256 r, __m256 g, __m256 b, float* rgb)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  alignas(32) float out[3][8];
+  _mm256_store_ps(out[0], _mm256_min_ps(_mm256_max_ps(r, zero), one));
+  _mm256_store_ps(out[1], _mm256_min_ps(_mm256_max_ps(g, zero), one));
+  _mm256_store_ps(out[2], _mm256_min_ps(_mm256_max_ps(b, zero), one));
+  for (int j = 0; j < 8; j++)
+  {
+    rgb[j*3 + 0] = out[0][j];
+    rgb[j*3 + 1] = out[1][j];
+    rgb[j*3 + 2] = out[2][j];
+  }
+}
+
+template<int mode>
+MIXBOX_TARGET_AVX2 static void float_rgb_to_latent_8_avx2(const float* rgb, float* latents_soa, size_t stride)
+{
+  __m256 r, g, b;
+  load_float_rgb_8_avx2(rgb, &r, &g, &b);
+  float_rgb_to_latent_8_avx2<mode>(r, g, b, latents_soa, stride);
+}
+
+MIXBOX_TARGET_AVX2 static void latent_to_float_rgb_8_avx2(const float* latents_soa, size_t stride, float* rgb)
+{
+  __m256 r, g, b;
+  eval_polynomial_8_avx2(_mm256_loadu_ps(latents_soa + 0*stride), _mm256_loadu_ps(latents_soa + 1*stride),
+                         _mm256_loadu_ps(latents_soa + 2*stride), _mm256_loadu_ps(latents_soa + 3*stride), &r, &g, &b);
+  store_float_rgb_8_avx2(_mm256_add_ps(r, _mm256_loadu_ps(latents_soa + 4*stride)),
+                         _mm256_add_ps(g, _mm256_loadu_ps(latents_soa + 5*stride)),
+                         _mm256_add_ps(b, _mm256_loadu_ps(latents_soa + 6*stride)), rgb);
+}
+
+MIXBOX_TARGET_AVX2 INLINE static __m256 transfer_lookup_8_avx2(const float* table, __m256 x)
+{
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+  x = _mm256_mul_ps(x, _mm256_set1_ps(float(MIXBOX_TRANSFER_STEPS)));
+  const __m256i i = _mm256_min_epi32(_mm256_cvttps_epi32(x), _mm256_set1_epi32(MIXBOX_TRANSFER_STEPS - 1));
+  const __m256 t = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i));
+  const __m256 y0 = _mm256_i32gather_ps(table, i, 4);
+  const __m256 y1 = _mm256_i32gather_ps(table + 1, i, 4);
+  return _mm256_fmadd_ps(t, _mm256_sub_ps(y1, y0), y0);
+}
+
+MIXBOX_TARGET_AVX2 static void transfer_lookup_n_avx2(const float* table, float* values, size_t count)
+{
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) { _mm256_storeu_ps(values + i, transfer_lookup_8_avx2(table, _mm256_loadu_ps(values + i))); }
+  for (; i < count; i++) { values[i] = transfer_lookup(table, values[i]); }
+}
+
+MIXBOX_TARGET_AVX2 static void srgb_to_linear_fast_n_avx2(float* values, size_t count)
+{
+  transfer_lookup_n_avx2(mixbox_transfer()->to_linear, values, count);
+}
+
+MIXBOX_TARGET_AVX2 static void linear_to_srgb_fast_n_avx2(float* values, size_t count)
+{
+  transfer_lookup_n_avx2(mixbox_transfer()->to_srgb, values, count);
+}
+
+template<int mode>
+MIXBOX_TARGET_AVX2 static void mix_n_8_avx2(const unsigned char* const* images, const float* weights, int k, size_t n, size_t j, unsigned char* out_rgb)
+{
+  const __m256 zero = _mm256_setzero_ps();
+
+  __m256 mix[MIXBOX_LATENT_SIZE];
+  for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = zero; }
+  __m256 sum = zero;
+
+  for (int i = 0; i < k; i++)
+  {
+    __m256 r, g, b;
+    load_rgb_8_avx2(images[i] + j*3, &r, &g, &b);
+    __m256 latent[MIXBOX_LATENT_SIZE];
+    float_rgb_to_latent_8_avx2<mode>(r, g, b, latent);
+    const __m256 w = _mm256_loadu_ps(weights + size_t(i)*n + j);
+    for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = _mm256_fmadd_ps(w, latent[c], mix[c]); }
+    sum = _mm256_add_ps(sum, w);
+  }
+
+  const __m256 norm = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), sum), _mm256_cmp_ps(sum, zero, _CMP_GT_OQ));
+  for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = _mm256_mul_ps(mix[c], norm); }
+
+  __m256 r, g, b;
+  eval_polynomial_8_avx2(mix[0], mix[1], mix[2], mix[3], &r, &g, &b);
+  store_rgb_8_avx2(_mm256_add_ps(r, mix[4]), _mm256_add_ps(g, mix[5]), _mm256_add_ps(b, mix[6]), out_rgb);
+}
+
+MIXBOX_TARGET_AVX2 static void pack_latent_8_avx2(const float* latents_soa, size_t stride, mixbox_packed_latent* packed)
+{
+  __m128i v[8];
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    const __m256 q = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(latents_soa + i*stride), _mm256_set1_ps(mixbox_packed_offset[i])), _mm256_set1_ps(1.0f / mixbox_packed_step[i]));
+    const __m256i codes = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_min_ps(_mm256_max_ps(q, _mm256_setzero_ps()), _mm256_set1_ps(65535.0f)), _mm256_set1_ps(0.5f)));
+    v[i] = _mm_packus_epi32(_mm256_castsi256_si128(codes), _mm256_extracti128_si256(codes, 1));
+  }
+  v[7] = _mm_setzero_si128();
+  transpose_8x8_epi16_sse41(v);
+  for (int j = 0; j < 8; j++) { _mm_storeu_si128((__m128i*)packed[j], v[j]); }
+}
 
-#ifdef _MSC_VER
-  #define INLINE __forceinline
-#elif defined(__GNUC__)
-  #define INLINE inline __attribute__((always_inline))
-#else
-  #define INLINE inline
+MIXBOX_TARGET_AVX2 static void unpack_latent_8_avx2(const mixbox_packed_latent* packed, float* latents_soa, size_t stride)
+{
+  __m128i v[8];
+  for (int j = 0; j < 8; j++) { v[j] = _mm_loadu_si128((const __m128i*)packed[j]); }
+  transpose_8x8_epi16_sse41(v);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    const __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v[i]));
+    _mm256_storeu_ps(latents_soa + i*stride, _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(mixbox_packed_step[i])), _mm256_set1_ps(mixbox_packed_offset[i])));
+  }
+}
+
+static const mixbox_kernels mixbox_kernels_avx2[MIXBOX_LUT_MODE_COUNT] =
+{
+#define MIXBOX_KERNELS(mode) \
+  { MIXBOX_ISA_AVX2, mode, float_rgb_to_latent_avx2<mode>, eval_polynomial_avx2, lerp_latent_avx2, \
+    rgb_to_latent_n_blocked<8, rgb_to_latent_8_avx2<mode>>, latent_to_rgb_n_blocked<8, latent_to_rgb_8_avx2>, \
+    float_rgb_to_latent_n_blocked<8, float_rgb_to_latent_8_avx2<mode>>, latent_to_float_rgb_n_blocked<8, latent_to_float_rgb_8_avx2>, \
+    srgb_to_linear_fast_n_avx2, linear_to_srgb_fast_n_avx2, mix_n_image_blocked<8, mix_n_8_avx2<mode>>, \
+    pack_latent_n_blocked<8, pack_latent_8_avx2>, unpack_latent_n_blocked<8, unpack_latent_8_avx2> },
+  MIXBOX_KERNELS(MIXBOX_LUT_TRILINEAR)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL_32)
+#undef MIXBOX_KERNELS
+};
+
+// ---- AVX-512F -----------------------------------------------------------------
+
+// GCC 12 flags the undefined-vector idiom inside its own _mm512 intrinsics (GCC bug 105593).
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wuninitialized"
+  #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
 #endif
 
-INLINE static float clamp01(float x)
+MIXBOX_TARGET_AVX512 INLINE static void eval_polynomial_16_avx512(__m512 c0, __m512 c1, __m512 c2, __m512 c3, __m512* out_r, __m512* out_g, __m512* out_b)
 {
-  return x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x;
+  const __m512 c00 = _mm512_mul_ps(c0, c0);
+  const __m512 c11 = _mm512_mul_ps(c1, c1);
+  const __m512 c22 = _mm512_mul_ps(c2, c2);
+  const __m512 c33 = _mm512_mul_ps(c3, c3);
+  const __m512 c01 = _mm512_mul_ps(c0, c1);
+  const __m512 c02 = _mm512_mul_ps(c0, c2);
+  const __m512 c12 = _mm512_mul_ps(c1, c2);
+
+  __m512 r = _mm512_setzero_ps();
+  __m512 g = _mm512_setzero_ps();
+  __m512 b = _mm512_setzero_ps();
+
+  __m512 w;
+#define MIXBOX_TERM(x, y, kr, kg, kb) \
+  w = _mm512_mul_ps(x, y); \
+  r = _mm512_fmadd_ps(_mm512_set1_ps(kr), w, r); \
+  g = _mm512_fmadd_ps(_mm512_set1_ps(kg), w, g); \
+  b = _mm512_fmadd_ps(_mm512_set1_ps(kb), w, b);
+  MIXBOX_POLYNOMIAL_TERMS(MIXBOX_TERM)
+#undef MIXBOX_TERM
+
+  *out_r = r;
+  *out_g = g;
+  *out_b = b;
 }
 
-INLINE static float srgb_to_linear(float x)
+MIXBOX_TARGET_AVX512 INLINE static void lut_tap_16_avx512(const unsigned char* p, __m512i idx, __m512 w, __m512* c0, __m512* c1, __m512* c2)
 {
-  return (x >= 0.04045f) ? std::pow((x + 0.055f) / 1.055f, 2.4f) : x/12.92f;
+  const __m512i mask = _mm512_set1_epi32(0xFF);
+  const __m512i v = _mm512_i32gather_epi32(idx, p, 1);
+  *c0 = _mm512_fmadd_ps(w, _mm512_cvtepi32_ps(_mm512_and_si512(v, mask)), *c0);
+  *c1 = _mm512_fmadd_ps(w, _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(v, 8), mask)), *c1);
+  *c2 = _mm512_fmadd_ps(w, _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(v, 16), mask)), *c2);
 }
 
-INLINE static float linear_to_srgb(float x)
+template<int mode>
+MIXBOX_TARGET_AVX512 INLINE static void lut_fetch_16_avx512(__m512 r, __m512 g, __m512 b, __m512* out_c0, __m512* out_c1, __m512* out_c2)
 {
-  return (x >= 0.0031308f) ? 1.055f*std::pow(x, 1.0f/2.4f) - 0.055f : 12.92f*x;
+  const bool lut32 = (mode == MIXBOX_LUT_TETRAHEDRAL_32);
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512 scale = _mm512_set1_ps(lut32 ? 31.0f : 63.0f);
+
+  const __m512 x = _mm512_mul_ps(r, scale);
+  const __m512 y = _mm512_mul_ps(g, scale);
+  const __m512 z = _mm512_mul_ps(b, scale);
+
+  __m512i ix = _mm512_cvttps_epi32(x);
+  __m512i iy = _mm512_cvttps_epi32(y);
+  __m512i iz = _mm512_cvttps_epi32(z);
+  if (lut32)
+  {
+    ix = _mm512_min_epi32(ix, _mm512_set1_epi32(30));
+    iy = _mm512_min_epi32(iy, _mm512_set1_epi32(30));
+    iz = _mm512_min_epi32(iz, _mm512_set1_epi32(30));
+  }
+
+  const __m512 tx = _mm512_sub_ps(x, _mm512_cvtepi32_ps(ix));
+  const __m512 ty = _mm512_sub_ps(y, _mm512_cvtepi32_ps(iy));
+  const __m512 tz = _mm512_sub_ps(z, _mm512_cvtepi32_ps(iz));
+
+  __m512i idx;
+  if (lut32)
+  {
+    idx = _mm512_add_epi32(ix, _mm512_add_epi32(_mm512_slli_epi32(iy, 5), _mm512_slli_epi32(iz, 10)));
+    idx = _mm512_slli_epi32(idx, 2);
+  }
+  else
+  {
+    idx = _mm512_add_epi32(ix, _mm512_add_epi32(_mm512_slli_epi32(iy, 6), _mm512_slli_epi32(iz, 12)));
+    idx = _mm512_and_si512(idx, _mm512_set1_epi32(0x3FFFF));
+    idx = _mm512_add_epi32(idx, _mm512_add_epi32(idx, idx));
+  }
+
+  __m512 c0 = _mm512_setzero_ps();
+  __m512 c1 = _mm512_setzero_ps();
+  __m512 c2 = _mm512_setzero_ps();
+
+  if constexpr (mode == MIXBOX_LUT_TRILINEAR)
+  {
+    const __m512 sx = _mm512_sub_ps(one, tx);
+    const __m512 sy = _mm512_sub_ps(one, ty);
+    const __m512 sz = _mm512_sub_ps(one, tz);
+
+    const unsigned char* const lut = mixbox_lut();
+    lut_tap_16_avx512(lut +   192, idx, _mm512_mul_ps(_mm512_mul_ps(sx, sy), sz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut +   195, idx, _mm512_mul_ps(_mm512_mul_ps(tx, sy), sz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut +   384, idx, _mm512_mul_ps(_mm512_mul_ps(sx, ty), sz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut +   387, idx, _mm512_mul_ps(_mm512_mul_ps(tx, ty), sz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut + 12480, idx, _mm512_mul_ps(_mm512_mul_ps(sx, sy), tz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut + 12483, idx, _mm512_mul_ps(_mm512_mul_ps(tx, sy), tz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut + 12672, idx, _mm512_mul_ps(_mm512_mul_ps(sx, ty), tz), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut + 12675, idx, _mm512_mul_ps(_mm512_mul_ps(tx, ty), tz), &c0, &c1, &c2);
+  }
+  else
+  {
+    const __m512i dx = _mm512_set1_epi32(lut32 ? MIXBOX_LUT32_DX : MIXBOX_LUT64_DX);
+    const __m512i dy = _mm512_set1_epi32(lut32 ? MIXBOX_LUT32_DY : MIXBOX_LUT64_DY);
+    const __m512i dz = _mm512_set1_epi32(lut32 ? MIXBOX_LUT32_DZ : MIXBOX_LUT64_DZ);
+    const __m512i dxyz = _mm512_set1_epi32(lut32 ? MIXBOX_LUT32_DX + MIXBOX_LUT32_DY + MIXBOX_LUT32_DZ
+                                                 : MIXBOX_LUT64_DX + MIXBOX_LUT64_DY + MIXBOX_LUT64_DZ);
+
+    // same selection as tetrahedral_taps, lane by lane
+    const __mmask16 x_max = _mm512_cmp_ps_mask(tx, ty, _CMP_GE_OQ) & _mm512_cmp_ps_mask(tx, tz, _CMP_GE_OQ);
+    const __mmask16 y_max = ~x_max & _mm512_cmp_ps_mask(ty, tz, _CMP_GE_OQ);
+    const __mmask16 z_min = _mm512_cmp_ps_mask(tz, ty, _CMP_LE_OQ) & _mm512_cmp_ps_mask(tz, tx, _CMP_LE_OQ);
+    const __mmask16 y_min = ~z_min & _mm512_cmp_ps_mask(ty, tx, _CMP_LE_OQ) & _mm512_cmp_ps_mask(ty, tz, _CMP_LE_OQ);
+
+    const __m512 t_max = _mm512_mask_blend_ps(x_max, _mm512_mask_blend_ps(y_max, tz, ty), tx);
+    const __m512 t_min = _mm512_mask_blend_ps(z_min, _mm512_mask_blend_ps(y_min, tx, ty), tz);
+    const __m512 t_mid = _mm512_max_ps(_mm512_min_ps(tx, ty), _mm512_min_ps(_mm512_max_ps(tx, ty), tz));
+
+    const __m512i step_max = _mm512_mask_blend_epi32(x_max, _mm512_mask_blend_epi32(y_max, dz, dy), dx);
+    const __m512i step_min = _mm512_mask_blend_epi32(z_min, _mm512_mask_blend_epi32(y_min, dx, dy), dz);
+
+    const unsigned char* const lut = lut32 ? mixbox_lut32() : mixbox_lut() + 192;
+    lut_tap_16_avx512(lut, idx, _mm512_sub_ps(one, t_max), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut, _mm512_add_epi32(idx, step_max), _mm512_sub_ps(t_max, t_mid), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut, _mm512_add_epi32(idx, _mm512_sub_epi32(dxyz, step_min)), _mm512_sub_ps(t_mid, t_min), &c0, &c1, &c2);
+    lut_tap_16_avx512(lut, _mm512_add_epi32(idx, dxyz), t_min, &c0, &c1, &c2);
+  }
+
+  const __m512 inv255 = _mm512_set1_ps(1.0f / 255.0f);
+  *out_c0 = _mm512_mul_ps(c0, inv255);
+  *out_c1 = _mm512_mul_ps(c1, inv255);
+  *out_c2 = _mm512_mul_ps(c2, inv255);
 }
 
-INLINE static void eval_polynomial(float c0, float c1, float c2, float c3, float* rgb)
+template<int mode>
+MIXBOX_TARGET_AVX512 INLINE static void float_rgb_to_latent_16_avx512(__m512 r, __m512 g, __m512 b, __m512* latent)
 {
-  float r = 0;
-  float g = 0;
-  float b = 0;
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 one = _mm512_set1_ps(1.0f);
+
+  r = _mm512_min_ps(_mm512_max_ps(r, zero), one);
+  g = _mm512_min_ps(_mm512_max_ps(g, zero), one);
+  b = _mm512_min_ps(_mm512_max_ps(b, zero), one);
+
+  __m512 c0, c1, c2;
+  lut_fetch_16_avx512<mode>(r, g, b, &c0, &c1, &c2);
+  const __m512 c3 = _mm512_sub_ps(one, _mm512_add_ps(_mm512_add_ps(c0, c1), c2));
+
+  __m512 mix_r, mix_g, mix_b;
+  eval_polynomial_16_avx512(c0, c1, c2, c3, &mix_r, &mix_g, &mix_b);
+
+  latent[0] = c0;
+  latent[1] = c1;
+  latent[2] = c2;
+  latent[3] = c3;
+  latent[4] = _mm512_sub_ps(r, mix_r);
+  latent[5] = _mm512_sub_ps(g, mix_g);
+  latent[6] = _mm512_sub_ps(b, mix_b);
+}
 
-  const float c00 = c0 * c0;
-  const float c11 = c1 * c1;
-  const float c22 = c2 * c2;
-  const float c33 = c3 * c3;
-  const float c01 = c0 * c1;
-  const float c02 = c0 * c2;
-  const float c12 = c1 * c2;
+template<int mode>
+MIXBOX_TARGET_AVX512 INLINE static void float_rgb_to_latent_16_avx512(__m512 r, __m512 g, __m512 b, float* latents_soa, size_t stride)
+{
+  __m512 latent[MIXBOX_LATENT_SIZE];
+  float_rgb_to_latent_16_avx512<mode>(r, g, b, latent);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { _mm512_storeu_ps(latents_soa + i*stride, latent[i]); }
+}
 
-  float w;
-  w = c0*c00; r += +0.07717053f*w; g += +0.02826978f*w; b += +0.24832992f*w;
-  w = c1*c11; r += +0.95912302f*w; g += +0.80256528f*w; b += +0.03561839f*w;
-  w = c2*c22; r += +0.74683774f*w; g += +0.04868586f*w; b += +0.00000000f*w;
-  w = c3*c33; r += +0.99518138f*w; g += +0.99978149f*w; b += +0.99704802f*w;
-  w = c00*c1; r += +0.04819146f*w; g += +0.83363781f*w; b += +0.32515377f*w;
-  w = c01*c1; r += -0.68146950f*w; g += +1.46107803f*w; b += +1.06980936f*w;
-  w = c00*c2; r += +0.27058419f*w; g += -0.15324870f*w; b += +1.98735057f*w;
-  w = c02*c2; r += +0.80478189f*w; g += +0.67093710f*w; b += +0.18424500f*w;
-  w = c00*c3; r += -0.35031003f*w; g += +1.37855826f*w; b += +3.68865000f*w;
-  w = c0*c33; r += +1.05128046f*w; g += +1.97815239f*w; b += +2.82989073f*w;
-  w = c11*c2; r += +3.21607125f*w; g += +0.81270228f*w; b += +1.03384539f*w;
-  w = c1*c22; r += +2.78893374f*w; g += +0.41565549f*w; b += -0.04487295f*w;
-  w = c11*c3; r += +3.02162577f*w; g += +2.55374103f*w; b += +0.32766114f*w;
-  w = c1*c33; r += +2.95124691f*w; g += +2.81201112f*w; b += +1.17578442f*w;
-  w = c22*c3; r += +2.82677043f*w; g += +0.79933038f*w; b += +1.81715262f*w;
-  w = c2*c33; r += +2.99691099f*w; g += +1.22593053f*w; b += +1.80653661f*w;
-  w = c01*c2; r += +1.87394106f*w; g += +2.05027182f*w; b += -0.29835996f*w;
-  w = c01*c3; r += +2.56609566f*w; g += +7.03428198f*w; b += +0.62575374f*w;
-  w = c02*c3; r += +4.08329484f*w; g += -1.40408358f*w; b += +2.14995522f*w;
-  w = c12*c3; r += +6.00078678f*w; g += +2.55552042f*w; b += +1.90739502f*w;
+MIXBOX_TARGET_AVX512 INLINE static __m512 combine_8_avx512(__m256 lo, __m256 hi)
+{
+  const __m512d wide = _mm512_insertf64x4(_mm512_setzero_pd(), _mm256_castps_pd(lo), 0);
+  return _mm512_castpd_ps(_mm512_insertf64x4(wide, _mm256_castps_pd(hi), 1));
+}
 
-  rgb[0] = r;
-  rgb[1] = g;
-  rgb[2] = b;
+template<int mode>
+MIXBOX_TARGET_AVX512 static void rgb_to_latent_16_avx512(const unsigned char* rgb, float* latents_soa, size_t stride)
+{
+  __m256 r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+  load_rgb_8_avx2(rgb, &r_lo, &g_lo, &b_lo);
+  load_rgb_8_avx2(rgb + 24, &r_hi, &g_hi, &b_hi);
+  float_rgb_to_latent_16_avx512<mode>(combine_8_avx512(r_lo, r_hi), combine_8_avx512(g_lo, g_hi), combine_8_avx512(b_lo, b_hi), latents_soa, stride);
 }
 
-INLINE static const unsigned char* mixbox_lut();
+MIXBOX_TARGET_AVX512 static void latent_to_rgb_16_avx512(const float* latents_soa, size_t stride, unsigned char* rgb)
+{
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512 scale = _mm512_set1_ps(255.0f);
+  const __m512 half = _mm512_set1_ps(0.5f);
+
+  __m512 r, g, b;
+  eval_polynomial_16_avx512(_mm512_loadu_ps(latents_soa + 0*stride), _mm512_loadu_ps(latents_soa + 1*stride),
+                            _mm512_loadu_ps(latents_soa + 2*stride), _mm512_loadu_ps(latents_soa + 3*stride), &r, &g, &b);
+  r = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(r, _mm512_loadu_ps(latents_soa + 4*stride)), zero), one);
+  g = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(g, _mm512_loadu_ps(latents_soa + 5*stride)), zero), one);
+  b = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(b, _mm512_loadu_ps(latents_soa + 6*stride)), zero), one);
+
+  alignas(64) int out[3][16];
+  _mm512_store_si512(out[0], _mm512_cvttps_epi32(_mm512_fmadd_ps(r, scale, half)));
+  _mm512_store_si512(out[1], _mm512_cvttps_epi32(_mm512_fmadd_ps(g, scale, half)));
+  _mm512_store_si512(out[2], _mm512_cvttps_epi32(_mm512_fmadd_ps(b, scale, half)));
+  for (int j = 0; j < 16; j++)
+  {
+    rgb[j*3 + 0] = (unsigned char)out[0][j];
+    rgb[j*3 + 1] = (unsigned char)out[1][j];
+    rgb[j*3 + 2] = (unsigned char)out[2][j];
+  }
+}
 
-INLINE static void float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+template<int mode>
+MIXBOX_TARGET_AVX512 static void float_rgb_to_latent_16_avx512(const float* rgb, float* latents_soa, size_t stride)
 {
-  r = clamp01(r);
-  g = clamp01(g);
-  b = clamp01(b);
+  const __m512i idx = _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45);
+  float_rgb_to_latent_16_avx512<mode>(_mm512_i32gather_ps(idx, rgb + 0, 4),
+                                      _mm512_i32gather_ps(idx, rgb + 1, 4),
+                                      _mm512_i32gather_ps(idx, rgb + 2, 4), latents_soa, stride);
+}
 
-  const float x = r * 63.0f;
-  const float y = g * 63.0f;
-  const float z = b * 63.0f;
+MIXBOX_TARGET_AVX512 static void latent_to_float_rgb_16_avx512(const float* latents_soa, size_t stride, float* rgb)
+{
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 one = _mm512_set1_ps(1.0f);
+
+  __m512 r, g, b;
+  eval_polynomial_16_avx512(_mm512_loadu_ps(latents_soa + 0*stride), _mm512_loadu_ps(latents_soa + 1*stride),
+                            _mm512_loadu_ps(latents_soa + 2*stride), _mm512_loadu_ps(latents_soa + 3*stride), &r, &g, &b);
+  r = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(r, _mm512_loadu_ps(latents_soa + 4*stride)), zero), one);
+  g = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(g, _mm512_loadu_ps(latents_soa + 5*stride)), zero), one);
+  b = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(b, _mm512_loadu_ps(latents_soa + 6*stride)), zero), one);
+
+  const __m512i idx = _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45);
+  _mm512_i32scatter_ps(rgb + 0, idx, r, 4);
+  _mm512_i32scatter_ps(rgb + 1, idx, g, 4);
+  _mm512_i32scatter_ps(rgb + 2, idx, b, 4);
+}
 
-  const int ix = int(x);
-  const int iy = int(y);
-  const int iz = int(z);
+MIXBOX_TARGET_AVX512 static void transfer_lookup_n_avx512(const float* table, float* values, size_t count)
+{
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512 steps = _mm512_set1_ps(float(MIXBOX_TRANSFER_STEPS));
+  const __m512i last = _mm512_set1_epi32(MIXBOX_TRANSFER_STEPS - 1);
 
-  const float tx = x - float(ix);
-  const float ty = y - float(iy);
-  const float tz = z - float(iz);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    const __m512 x = _mm512_mul_ps(_mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(values + i), zero), one), steps);
+    const __m512i k = _mm512_min_epi32(_mm512_cvttps_epi32(x), last);
+    const __m512 t = _mm512_sub_ps(x, _mm512_cvtepi32_ps(k));
+    const __m512 y0 = _mm512_i32gather_ps(k, table, 4);
+    const __m512 y1 = _mm512_i32gather_ps(k, table + 1, 4);
+    _mm512_storeu_ps(values + i, _mm512_fmadd_ps(t, _mm512_sub_ps(y1, y0), y0));
+  }
+  for (; i < count; i++) { values[i] = transfer_lookup(table, values[i]); }
+}
 
-  const unsigned char* const lut_ptr = &(mixbox_lut()[((ix + iy*64 + iz*64*64) & 0x3FFFF) * 3]);
+MIXBOX_TARGET_AVX512 static void srgb_to_linear_fast_n_avx512(float* values, size_t count)
+{
+  transfer_lookup_n_avx512(mixbox_transfer()->to_linear, values, count);
+}
 
-  float c0 = 0;
-  float c1 = 0;
-  float c2 = 0;
+MIXBOX_TARGET_AVX512 static void linear_to_srgb_fast_n_avx512(float* values, size_t count)
+{
+  transfer_lookup_n_avx512(mixbox_transfer()->to_srgb, values, count);
+}
 
-  float w;
-  w = (1.0f-tx)*(1.0f-ty)*(1.0f-tz); c0 += w*lut_ptr[  192]; c1 += w*lut_ptr[  193]; c2 += w*lut_ptr[  194];
-  w = (     tx)*(1.0f-ty)*(1.0f-tz); c0 += w*lut_ptr[  195]; c1 += w*lut_ptr[  196]; c2 += w*lut_ptr[  197];
-  w = (1.0f-tx)*(     ty)*(1.0f-tz); c0 += w*lut_ptr[  384]; c1 += w*lut_ptr[  385]; c2 += w*lut_ptr[  386];
-  w = (     tx)*(     ty)*(1.0f-tz); c0 += w*lut_ptr[  387]; c1 += w*lut_ptr[  388]; c2 += w*lut_ptr[  389];
-  w = (1.0f-tx)*(1.0f-ty)*(     tz); c0 += w*lut_ptr[12480]; c1 += w*lut_ptr[12481]; c2 += w*lut_ptr[12482];
-  w = (     tx)*(1.0f-ty)*(     tz); c0 += w*lut_ptr[12483]; c1 += w*lut_ptr[12484]; c2 += w*lut_ptr[12485];
-  w = (1.0f-tx)*(     ty)*(     tz); c0 += w*lut_ptr[12672]; c1 += w*lut_ptr[12673]; c2 += w*lut_ptr[12674];
-  w = (     tx)*(     ty)*(     tz); c0 += w*lut_ptr[12675]; c1 += w*lut_ptr[12676]; c2 += w*lut_ptr[12677];
-
-  c0 *= (1.0f / 255.0f);
-  c1 *= (1.0f / 255.0f);
-  c2 *= (1.0f / 255.0f);
+template<int mode>
+MIXBOX_TARGET_AVX512 static void mix_n_16_avx512(const unsigned char* const* images, const float* weights, int k, size_t n, size_t j, unsigned char* out_rgb)
+{
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 one = _mm512_set1_ps(1.0f);
 
-  const float c3 = 1.0f - (c0 + c1 + c2);
+  __m512 mix[MIXBOX_LATENT_SIZE];
+  for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = zero; }
+  __m512 sum = zero;
 
-  float mixrgb[3];
-  eval_polynomial(c0, c1, c2, c3, mixrgb);
+  for (int i = 0; i < k; i++)
+  {
+    __m256 r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+    load_rgb_8_avx2(images[i] + j*3, &r_lo, &g_lo, &b_lo);
+    load_rgb_8_avx2(images[i] + j*3 + 24, &r_hi, &g_hi, &b_hi);
+    __m512 latent[MIXBOX_LATENT_SIZE];
+    float_rgb_to_latent_16_avx512<mode>(combine_8_avx512(r_lo, r_hi), combine_8_avx512(g_lo, g_hi), combine_8_avx512(b_lo, b_hi), latent);
+    const __m512 w = _mm512_loadu_ps(weights + size_t(i)*n + j);
+    for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = _mm512_fmadd_ps(w, latent[c], mix[c]); }
+    sum = _mm512_add_ps(sum, w);
+  }
 
-  out_latent[0] = c0;
-  out_latent[1] = c1;
-  out_latent[2] = c2;
-  out_latent[3] = c3;
-  out_latent[4] = r - mixrgb[0];
-  out_latent[5] = g - mixrgb[1];
-  out_latent[6] = b - mixrgb[2];
+  const __m512 norm = _mm512_maskz_div_ps(_mm512_cmp_ps_mask(sum, zero, _CMP_GT_OQ), one, sum);
+  for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] = _mm512_mul_ps(mix[c], norm); }
+
+  __m512 r, g, b;
+  eval_polynomial_16_avx512(mix[0], mix[1], mix[2], mix[3], &r, &g, &b);
+  r = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(r, mix[4]), zero), one);
+  g = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(g, mix[5]), zero), one);
+  b = _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(b, mix[6]), zero), one);
+
+  const __m512 scale = _mm512_set1_ps(255.0f);
+  const __m512 half = _mm512_set1_ps(0.5f);
+  alignas(64) int out[3][16];
+  _mm512_store_si512(out[0], _mm512_cvttps_epi32(_mm512_fmadd_ps(r, scale, half)));
+  _mm512_store_si512(out[1], _mm512_cvttps_epi32(_mm512_fmadd_ps(g, scale, half)));
+  _mm512_store_si512(out[2], _mm512_cvttps_epi32(_mm512_fmadd_ps(b, scale, half)));
+  for (int q = 0; q < 16; q++)
+  {
+    out_rgb[q*3 + 0] = (unsigned char)out[0][q];
+    out_rgb[q*3 + 1] = (unsigned char)out[1][q];
+    out_rgb[q*3 + 2] = (unsigned char)out[2][q];
+  }
 }
 
-INLINE static void latent_to_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+// Single-pixel paths gain nothing from 16 lanes, so they reuse the AVX2 kernels.
+// 16 latents as two 8x8 transposes, the low and high halves of each component row.
+MIXBOX_TARGET_AVX512 static void pack_latent_16_avx512(const float* latents_soa, size_t stride, mixbox_packed_latent* packed)
 {
-  float rgb[3];
-  eval_polynomial(latent[0], latent[1], latent[2], latent[3], rgb);
-  *out_r = clamp01(rgb[0] + latent[4]);
-  *out_g = clamp01(rgb[1] + latent[5]);
-  *out_b = clamp01(rgb[2] + latent[6]);
+  __m128i lo[8];
+  __m128i hi[8];
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    const __m512 q = _mm512_mul_ps(_mm512_sub_ps(_mm512_loadu_ps(latents_soa + i*stride), _mm512_set1_ps(mixbox_packed_offset[i])), _mm512_set1_ps(1.0f / mixbox_packed_step[i]));
+    const __m256i codes = _mm512_cvtepi32_epi16(_mm512_cvttps_epi32(_mm512_add_ps(_mm512_min_ps(_mm512_max_ps(q, _mm512_setzero_ps()), _mm512_set1_ps(65535.0f)), _mm512_set1_ps(0.5f))));
+    lo[i] = _mm256_castsi256_si128(codes);
+    hi[i] = _mm256_extracti128_si256(codes, 1);
+  }
+  lo[7] = _mm_setzero_si128();
+  hi[7] = _mm_setzero_si128();
+  transpose_8x8_epi16_sse41(lo);
+  transpose_8x8_epi16_sse41(hi);
+  for (int j = 0; j < 8; j++)
+  {
+    _mm_storeu_si128((__m128i*)packed[j + 0], lo[j]);
+    _mm_storeu_si128((__m128i*)packed[j + 8], hi[j]);
+  }
 }
 
-INLINE static void latent_to_rgb(mixbox_latent latent, unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+MIXBOX_TARGET_AVX512 static void unpack_latent_16_avx512(const mixbox_packed_latent* packed, float* latents_soa, size_t stride)
 {
-  float r, g, b;
-  latent_to_float_rgb(latent, &r, &g, &b);
-  *out_r = (unsigned char)((int)(r*255.0f + 0.5f));
-  *out_g = (unsigned char)((int)(g*255.0f + 0.5f));
-  *out_b = (unsigned char)((int)(b*255.0f + 0.5f));
+  __m128i lo[8];
+  __m128i hi[8];
+  for (int j = 0; j < 8; j++)
+  {
+    lo[j] = _mm_loadu_si128((const __m128i*)packed[j + 0]);
+    hi[j] = _mm_loadu_si128((const __m128i*)packed[j + 8]);
+  }
+  transpose_8x8_epi16_sse41(lo);
+  transpose_8x8_epi16_sse41(hi);
+  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  {
+    const __m512 x = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_inserti128_si256(_mm256_castsi128_si256(lo[i]), hi[i], 1)));
+    _mm512_storeu_ps(latents_soa + i*stride, _mm512_add_ps(_mm512_mul_ps(x, _mm512_set1_ps(mixbox_packed_step[i])), _mm512_set1_ps(mixbox_packed_offset[i])));
+  }
 }
 
-INLINE static void rgb_to_latent(unsigned char r, unsigned char g, unsigned char b, mixbox_latent out_latent)
+static const mixbox_kernels mixbox_kernels_avx512[MIXBOX_LUT_MODE_COUNT] =
+{
+#define MIXBOX_KERNELS(mode) \
+  { MIXBOX_ISA_AVX512, mode, float_rgb_to_latent_avx2<mode>, eval_polynomial_avx2, lerp_latent_avx2, \
+    rgb_to_latent_n_blocked<16, rgb_to_latent_16_avx512<mode>>, latent_to_rgb_n_blocked<16, latent_to_rgb_16_avx512>, \
+    float_rgb_to_latent_n_blocked<16, float_rgb_to_latent_16_avx512<mode>>, latent_to_float_rgb_n_blocked<16, latent_to_float_rgb_16_avx512>, \
+    srgb_to_linear_fast_n_avx512, linear_to_srgb_fast_n_avx512, mix_n_image_blocked<16, mix_n_16_avx512<mode>>, \
+    pack_latent_n_blocked<16, pack_latent_16_avx512>, unpack_latent_n_blocked<16, unpack_latent_16_avx512> },
+  MIXBOX_KERNELS(MIXBOX_LUT_TRILINEAR)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL)
+  MIXBOX_KERNELS(MIXBOX_LUT_TETRAHEDRAL_32)
+#undef MIXBOX_KERNELS
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic pop
+#endif
+
+#endif
+
+// ---- Dispatch -----------------------------------------------------------------
+
+static int cpu_supports(mixbox_isa isa)
 {
-  float_rgb_to_latent(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f, out_latent);
+  if (isa == MIXBOX_ISA_SCALAR) return 1;
+#if defined(MIXBOX_X86) && defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+  __cpuid(info, 1);
+  const int sse41 = (info[2] >> 19) & 1;
+  const int fma = (info[2] >> 12) & 1;
+  const int osxsave = (info[2] >> 27) & 1;
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  int leaf7_ebx = 0;
+  if (max_leaf >= 7) { __cpuidex(info, 7, 0); leaf7_ebx = info[1]; }
+  const int avx2 = fma && ((leaf7_ebx >> 5) & 1) && (xcr0 & 0x6) == 0x6;
+  const int avx512 = avx2 && ((leaf7_ebx >> 16) & 1) && (xcr0 & 0xE6) == 0xE6;
+#elif defined(MIXBOX_X86)
+  __builtin_cpu_init();
+  const int sse41 = __builtin_cpu_supports("sse4.1");
+  const int avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  const int avx512 = avx2 && __builtin_cpu_supports("avx512f");
+#else
+  const int sse41 = 0;
+  const int avx2 = 0;
+  const int avx512 = 0;
+#endif
+  switch (isa)
+  {
+    case MIXBOX_ISA_SSE41:  return sse41;
+    case MIXBOX_ISA_AVX2:   return avx2;
+    case MIXBOX_ISA_AVX512: return avx512;
+    default:                return 0;
+  }
 }
 
-INLINE static void linear_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+static const mixbox_kernels* kernels_for(mixbox_isa isa, mixbox_lut_mode mode)
 {
-  float_rgb_to_latent(linear_to_srgb(r),
-                      linear_to_srgb(g),
-                      linear_to_srgb(b),
-                      out_latent);
+  switch (isa)
+  {
+#ifdef MIXBOX_X86
+    case MIXBOX_ISA_SSE41:  return &mixbox_kernels_sse41[mode];
+    case MIXBOX_ISA_AVX2:   return &mixbox_kernels_avx2[mode];
+    case MIXBOX_ISA_AVX512: return &mixbox_kernels_avx512[mode];
+#endif
+    default:                return &mixbox_kernels_scalar[mode];
+  }
 }
 
-INLINE static void latent_to_linear_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+static mixbox_isa best_supported_isa()
 {
-  float rgb[3];
-  latent_to_float_rgb(latent, &rgb[0], &rgb[1], &rgb[2]);
-  *out_r = srgb_to_linear(rgb[0]);
-  *out_g = srgb_to_linear(rgb[1]);
-  *out_b = srgb_to_linear(rgb[2]);
+  if (cpu_supports(MIXBOX_ISA_AVX512)) return MIXBOX_ISA_AVX512;
+  if (cpu_supports(MIXBOX_ISA_AVX2))   return MIXBOX_ISA_AVX2;
+  if (cpu_supports(MIXBOX_ISA_SSE41))  return MIXBOX_ISA_SSE41;
+  return MIXBOX_ISA_SCALAR;
 }
 
-void mixbox_rgb_to_latent(unsigned char r, unsigned char g, unsigned char b, mixbox_latent out_latent)
+// Honors MIXBOX_ISA=scalar|sse4.1|avx2|avx512 when the cpu supports the requested path.
+static mixbox_isa startup_isa()
 {
-  rgb_to_latent(r, g, b, out_latent);
+  const char* forced = getenv("MIXBOX_ISA");
+  if (forced)
+  {
+    for (int isa = MIXBOX_ISA_SCALAR; isa <= MIXBOX_ISA_AVX512; isa++)
+    {
+      if (strcmp(forced, mixbox_isa_name((mixbox_isa)isa)) == 0 && cpu_supports((mixbox_isa)isa)) return (mixbox_isa)isa;
+    }
+  }
+  return best_supported_isa();
 }
 
-void mixbox_latent_to_rgb(mixbox_latent latent, unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+static std::atomic<const mixbox_kernels*> mixbox_active_kernels(nullptr);
+
+INLINE static const mixbox_kernels* mixbox_dispatch()
 {
-  latent_to_rgb(latent, out_r, out_g, out_b);
+  const mixbox_kernels* kernels = mixbox_active_kernels.load(std::memory_order_acquire);
+  if (kernels) return kernels;
+
+  const mixbox_kernels* expected = nullptr;
+  const mixbox_kernels* detected = kernels_for(startup_isa(), MIXBOX_LUT_TRILINEAR);
+  return mixbox_active_kernels.compare_exchange_strong(expected, detected, std::memory_order_acq_rel) ? detected : expected;
 }
 
-void mixbox_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+int mixbox_isa_supported(mixbox_isa isa)
 {
-  float_rgb_to_latent(r, g, b, out_latent);
+  return isa == MIXBOX_ISA_AUTO ? 1 : cpu_supports(isa);
 }
 
-void mixbox_linear_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent)
+int mixbox_set_isa(mixbox_isa isa)
 {
-  linear_float_rgb_to_latent(r, g, b, out_latent);
+  if (isa == MIXBOX_ISA_AUTO) isa = startup_isa();
+  if (!cpu_supports(isa)) return 0;
+  mixbox_active_kernels.store(kernels_for(isa, mixbox_dispatch()->lut_mode), std::memory_order_release);
+  return 1;
 }
 
-void mixbox_latent_to_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+mixbox_isa mixbox_get_isa(void)
 {
-  latent_to_float_rgb(latent, out_r, out_g, out_b);
+  return mixbox_dispatch()->isa;
 }
 
-void mixbox_latent_to_linear_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b)
+const char* mixbox_isa_name(mixbox_isa isa)
 {
-  latent_to_linear_float_rgb(latent, out_r, out_g, out_b);
+  switch (isa)
+  {
+    case MIXBOX_ISA_AUTO:   return "auto";
+    case MIXBOX_ISA_SCALAR: return "scalar";
+    case MIXBOX_ISA_SSE41:  return "sse4.1";
+    case MIXBOX_ISA_AVX2:   return "avx2";
+    case MIXBOX_ISA_AVX512: return "avx512";
+    default:                return "unknown";
+  }
 }
 
-void mixbox_lerp(unsigned char r1, unsigned char g1, unsigned char b1,
-                 unsigned char r2, unsigned char g2, unsigned char b2,
-                 float t,
-                 unsigned char* out_r, unsigned char* out_g, unsigned char* out_b)
+void mixbox_set_lut_mode(mixbox_lut_mode mode)
 {
-  mixbox_latent latent1;
-  mixbox_latent latent2;
+  if (mode < MIXBOX_LUT_TRILINEAR || mode >= MIXBOX_LUT_MODE_COUNT) return;
+  if (mode == MIXBOX_LUT_TETRAHEDRAL_32) mixbox_lut32();
+  mixbox_active_kernels.store(kernels_for(mixbox_dispatch()->isa, mode), std::memory_order_release);
+}
 
-  rgb_to_latent(r1, g1, b1, latent1);
-  rgb_to_latent(r2, g2, b2, latent2);
+mixbox_lut_mode mixbox_get_lut_mode(void)
+{
+  return mixbox_dispatch()->lut_mode;
+}
 
-  mixbox_latent latent_mix;
+// sRGB float -> CIE L*a*b* (D65), only used to score the LUT modes.
+static void float_rgb_to_lab(const float* rgb, float* lab)
+{
+  float lin[3];
+  for (int i = 0; i < 3; i++) { lin[i] = srgb_to_linear(clamp01(rgb[i])); }
 
-  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  const float xyz[3] =
   {
-    latent_mix[i] = (1.0f-t)*latent1[i] + t*latent2[i];
-  }
+    (0.4124564f*lin[0] + 0.3575761f*lin[1] + 0.1804375f*lin[2]) / 0.95047f,
+    (0.2126729f*lin[0] + 0.7151522f*lin[1] + 0.0721750f*lin[2]),
+    (0.0193339f*lin[0] + 0.1191920f*lin[1] + 0.9503041f*lin[2]) / 1.08883f,
+  };
 
-  latent_to_rgb(latent_mix, out_r, out_g, out_b);
+  float f[3];
+  for (int i = 0; i < 3; i++) { f[i] = xyz[i] > 216.0f/24389.0f ? std::cbrt(xyz[i]) : (24389.0f/27.0f*xyz[i] + 16.0f) / 116.0f; }
+
+  lab[0] = 116.0f*f[1] - 16.0f;
+  lab[1] = 500.0f*(f[0] - f[1]);
+  lab[2] = 200.0f*(f[1] - f[2]);
 }
 
-void mixbox_lerp_float(float r1, float g1, float b1,
-                       float r2, float g2, float b2,
-                       float t,
-                       float* out_r, float* out_g, float* out_b)
+void mixbox_lut_mode_error(mixbox_lut_mode mode, float* out_max_delta_e, float* out_mean_delta_e)
 {
-  mixbox_latent latent1;
-  mixbox_latent latent2;
+  if (mode < MIXBOX_LUT_TRILINEAR || mode >= MIXBOX_LUT_MODE_COUNT) return;
 
-  float_rgb_to_latent(r1, g1, b1, latent1);
-  float_rgb_to_latent(r2, g2, b2, latent2);
+  const mixbox_kernels* const reference = &mixbox_kernels_scalar[MIXBOX_LUT_TRILINEAR];
+  const mixbox_kernels* const candidate = &mixbox_kernels_scalar[mode];
 
-  mixbox_latent latent_mix;
+  const int samples = 65536;
+  unsigned int seed = 12345;
+  double max_delta_e = 0.0;
+  double sum_delta_e = 0.0;
 
-  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
+  for (int i = 0; i < samples; i++)
+  {
+    float rgb[2][3];
+    for (int j = 0; j < 6; j++)
+    {
+      seed = seed*1664525u + 1013904223u;
+      rgb[j / 3][j % 3] = float(seed >> 24) / 255.0f;
+    }
+
+    float lab[2][3];
+    for (int k = 0; k < 2; k++)
+    {
+      const mixbox_kernels* const kernels = k == 0 ? reference : candidate;
+      mixbox_latent latent[3];
+      kernels->float_rgb_to_latent(rgb[0][0], rgb[0][1], rgb[0][2], latent[0]);
+      kernels->float_rgb_to_latent(rgb[1][0], rgb[1][1], rgb[1][2], latent[1]);
+      kernels->lerp_latent(latent[0], latent[1], 0.5f, latent[2]);
+
+      float mix[3];
+      kernels->eval_polynomial(latent[2][0], latent[2][1], latent[2][2], latent[2][3], mix);
+      for (int c = 0; c < 3; c++) { mix[c] += latent[2][4 + c]; }
+      float_rgb_to_lab(mix, lab[k]);
+    }
+
+    const double delta_e = std::sqrt(double((lab[0][0]-lab[1][0])*(lab[0][0]-lab[1][0]) +
+                                            (lab[0][1]-lab[1][1])*(lab[0][1]-lab[1][1]) +
+                                            (lab[0][2]-lab[1][2])*(lab[0][2]-lab[1][2])));
+    if (delta_e > max_delta_e) max_delta_e = delta_e;
+    sum_delta_e += delta_e;
+  }
+
+  if (out_max_delta_e) *out_max_delta_e = float(max_delta_e);
+  if (out_mean_delta_e) *out_mean_delta_e = float(sum_delta_e / samples);
+}
+
+void mixbox_mix_n(const mixbox_latent* inputs, const float* weights, int n, mixbox_latent out_latent)
+{
+  float mix[MIXBOX_LATENT_SIZE] = {0};
+  float sum = 0;
+  for (int i = 0; i < n; i++)
   {
-    latent_mix[i] = (1.0f-t)*latent1[i] + t*latent2[i];
+    for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { mix[c] += weights[i]*inputs[i][c]; }
+    sum += weights[i];
   }
+  const float norm = sum > 0.0f ? 1.0f / sum : 0.0f;
+  for (int c = 0; c < MIXBOX_LATENT_SIZE; c++) { out_latent[c] = mix[c]*norm; }
+}
 
-  latent_to_float_rgb(latent_mix, out_r, out_g, out_b);
+void mixbox_mix_n_image(const unsigned char* const* images, const float* weights, int k, size_t n, unsigned char* out_rgb)
+{
+  mixbox_dispatch()->mix_n_image(images, weights, k < 0 ? 0 : k, n, out_rgb);
 }
 
-void mixbox_lerp_linear_float(float r1, float g1, float b1,
-                              float r2, float g2, float b2,
-                              float t,
-                              float* out_r, float* out_g, float* out_b)
+void mixbox_set_transfer_mode(mixbox_transfer_mode mode)
 {
-  mixbox_latent latent1;
-  mixbox_latent latent2;
+  if (mode != MIXBOX_TRANSFER_EXACT && mode != MIXBOX_TRANSFER_FAST) return;
+  if (mode == MIXBOX_TRANSFER_FAST) mixbox_transfer();
+  mixbox_active_transfer.store(mode, std::memory_order_relaxed);
+}
 
-  linear_float_rgb_to_latent(r1, g1, b1, latent1);
-  linear_float_rgb_to_latent(r2, g2, b2, latent2);
+mixbox_transfer_mode mixbox_get_transfer_mode(void)
+{
+  return mixbox_active_transfer.load(std::memory_order_relaxed);
+}
 
-  mixbox_latent latent_mix;
+void mixbox_rgb_to_latent_n(const unsigned char* rgb, size_t n, float* latents_soa)
+{
+  mixbox_dispatch()->rgb_to_latent_n(rgb, n, latents_soa);
+}
 
-  for (int i = 0; i < MIXBOX_LATENT_SIZE; i++)
-  {
-    latent_mix[i] = (1.0f-t)*latent1[i] + t*latent2[i];
-  }
+void mixbox_latent_to_rgb_n(const float* latents_soa, size_t n, unsigned char* rgb)
+{
+  mixbox_dispatch()->latent_to_rgb_n(latents_soa, n, rgb);
+}
 
-  latent_to_linear_float_rgb(latent_mix, out_r, out_g, out_b);
+void mixbox_float_rgb_to_latent_n(const float* rgb, size_t n, float* latents_soa)
+{
+  mixbox_dispatch()->float_rgb_to_latent_n(rgb, n, latents_soa, nullptr);
+}
+
+void mixbox_latent_to_float_rgb_n(const float* latents_soa, size_t n, float* rgb)
+{
+  mixbox_dispatch()->latent_to_float_rgb_n(latents_soa, n, rgb, nullptr);
+}
+
+void mixbox_linear_float_rgb_to_latent_n(const float* rgb, size_t n, float* latents_soa)
+{
+  const mixbox_kernels* const kernels = mixbox_dispatch();
+  const bool fast = mixbox_active_transfer.load(std::memory_order_relaxed) == MIXBOX_TRANSFER_FAST;
+  kernels->float_rgb_to_latent_n(rgb, n, latents_soa, fast ? kernels->linear_to_srgb_fast_n : linear_to_srgb_exact_n);
+}
+
+void mixbox_latent_to_linear_float_rgb_n(const float* latents_soa, size_t n, float* rgb)
+{
+  const mixbox_kernels* const kernels = mixbox_dispatch();
+  const bool fast = mixbox_active_transfer.load(std::memory_order_relaxed) == MIXBOX_TRANSFER_FAST;
+  kernels->latent_to_float_rgb_n(latents_soa, n, rgb, fast ? kernels->srgb_to_linear_fast_n : srgb_to_linear_exact_n);
+}
+
+void mixbox_pack_latent_n(const float* latents_soa, size_t n, mixbox_packed_latent* out_packed)
+{
+  mixbox_dispatch()->pack_latent_n(latents_soa, n, out_packed);
+}
+
+void mixbox_unpack_latent_n(const mixbox_packed_latent* packed, size_t n, float* latents_soa)
+{
+  mixbox_dispatch()->unpack_latent_n(packed, n, latents_soa);
+}
+
+#ifdef MIXBOX_RAW_LUT
+
+// Generated at build time by mixbox_lutgen, so the table is plain read-only data
+// and mixbox_lut() does no work on first use.
+#include "mixbox_lut_raw.inc"
+
+INLINE static const unsigned char* mixbox_lut()
+{
+  return mixbox_lut_raw;
 }
 
+#else
+
 static const char* mixbox_lut_compressed[] =
 {
   "Y_4H8E8b(No7xgiXspim?\?;c^Nh9gZ[Y4hIA`P^oa-KlSP(q12Zbc'[;L.x:Jp:Fi=g(;TR1h_L@wXPmAxcw>sUJVclFj*,h=<(N-5V+NOSdCfQ]+,])_Fok#uwI17WW84^Uq*7Gu-UKu#UNI>?.Rt]JqR1_8jk/5`#8-R`1Ik*h#=Wms`LBPxhkt1<P38x8@q8uDsj/4*aw5u'aQ(.A5CXI<d<Q8sPHR,M;aGi174#BEZf[f4b<23CqI$A:.)IoS+8mnd6ljs>u3UUbcc0(]eCp:kKfn?15gDJcG8'u>9upwptk*ih=*DrOb%S3lC1Yr)RoC#ul*4EawhL;tm4)DFqMO?sF5@WHtRhZ#(3iSU$O-B,)8dp_q[VEftFDC5h@rI&69u1>39s-GYO7dq^R')XKr_fortbZ...Bxd8GO<EB4C._RwMCR2Za@GTJcGPuUnt$t487xia$5wY[qw=n&hQ#Y9b#Y8lbtXB'L)v[MSbw.cD,1Y1A,,Sa.3pw9*V@iT;J+D+r(C$EYBPqtMc).,rvQ#bTH_04fFik_<>5nKuAe^?t[<w&Wjv6`VHOm'5#W:^?,U&WHPv4EI(0g@rHUlo<xL2IFuGh2vNe7lp*Ci>@CtHwU^IV*DfYha]5,wwO'u4]NCC5jF'jcfu&X)Fjv=FMQ(ZQ(E$-bP3e&1+NHBIop@LME$Wq;Cd^l1jsflu;dt&g]1(kJ^.DFETdL)Qrukvj+H=gvmKI%]-vb]ZxpX>KcK52`5$n+eC%[8?2D8X0KMo#?:3v5udr@J$.LtxrPe$lxf2NmYMk'w#.^g@i#psWp95N?R#<[dUnj4-]Ps&+B:M<8f?.&jcLuC$5E$QtDwtrk1.T2u)u?qsw]<Kot)QqHx/f:N*);1uNj/V;cDC-Iqn;?,H>m$9_BO4bQd0olP<8=Xg[a:@_:];T$@-1T&u?,fp^TtVE3@nW,;e-`dL+Tbgmt2DN%?V:d%HSre9I$^rvn+CWDQs5$?+JmnHab:<-_SRi=h)8NE;ZTG]mQDZlT(<Yu=-b]5Vw#dKPrhvkVv:A@Oh^PQ@gXVgUS8X<EK1D%t1j4We_,9@takJ0;N%EWJd5-D757K#tdxAG*A::#Ihe`w^c.dd=Rj@=XSIgmeWb%:uipN_I/1F'b.+oQfAG%HEc:aDQu]x'*t@Pg@rwvWioSVsjS>[eVb#7VGmD`upd'5+]X>EHqtp)SXC#b=jad8hgnbm`@LjE+@.Vm]lXbhZMRFKVSp+[l-fl7'b*5nBg]Qu+HiBn%hqq_'qc[&D1;:q.]4v>ieT[#Tui=?pCLKtFAs1]#T5%?g^_b`/=u66@.M^]$4t+$Qidn%(h*4Bvml7((q-O:ZV&;MEQS@*8Q79_=t#;D4-]&=0?T;iv&qj[U69tq)@0qw1LgUjQY]+]=ul?F'KC4416<PbK,7HI@iq^P;EajLJ4Gi>(M8:)?BgE$c[*8`1bI0&^a/2hM5XI&Fne1pBsohq]*o+ek(fLaMf6>CsC),2TI3=LP//J_ncuDt/3#hvUL;17+(pgjrKk6g_A1BXht/H=Q,`*`'8sv$+AoWMAD+)k*KdvgJ<jYn(Eemx(^upQ)@O5Iw@Q5Ul8B#2uC/WvQ^F;a$*1`)s>&]0m?Ag?oencpd1NqP#P,Te_f[mt9*t);TmvZ,Wa*[mP;$#VOj/BDf&DCOt2bUJ]`n<W*4m#s1]_qTin*t]k[gUZh&S$-jFD=;n4`P^DNZWrPqER*C.8;)j*NjNMN&Y3mm4B,i]>-Up&SRt>R/m(N-b2pFDTs@xKl<.eff)%vOhAndrM(h@lPj<*g*>d?4qvn1u@f]?r%tOQ2Gwg;6S;ZS@)c=M.GMjgq=1bpQWtn@WAeX2aAf6eaZ5f>6sSV'(k7EL@q][+%/qO,(O9-:kDW<.g3+RtoMiOmX5xA'FB2.,>Qxr@DX$EwX1ZZgK1kwxg`u$(MW7[G/90xGn1o]Kk<=uT?GjDw1[^`'=f%an`vZ)Cpv,I3=QH:rFtL)<N@%jds*8W3C_*J3,k<dp7T8[)p*uSV<TL3@7>rL[C`5c9S&tR%<Csm*=KtpPEgEO*WB`X_n0-P9Vdg'?JL4k3j_c%nhv_9X&RF]6#DSB6D+u8c:`;DkYR71[NY0g)tJpgD?D`wqQNtu'qX$<P@uWD_FcF.c%+72hH`wwL0(CPC75^'7V1cS7BN^ADeIs*Idn_xYKiV8h*MK=,GR<CM;g0Ak'`FtDufqtjQD+GwDP#W,>PTxXB]OIa]%57O1=v5*gN]BB^5+s?QNf2$ujT2&Dci.QH/)5%5i@B2B4r<eD8&.1Mf##k$cqNE:`AdEr?.nn<6a8X4Cv&^Nb['L,]&d`@=wH,]Six_&&vPL0xSn_X?7Q^IW*oPDvpj-Jc9Lvox9]BL]*:qkPtN@XNc9sN?e*<V$DqA_uL9:RH<0d;Pf=u`g8KS-epugdO_;%^MSFN``N6qT#gY7e9:g&[.<apl-`EF+Z0;JI>&<tP4W;VL/+d21Ol>_-vi@YZIs@(C*T2kVR5<s'ZKi2ac_Y=P-,I`#RjXh&+xe&@It)pE$]bD3ZP#+eTV`gSMX[K`ru`R%YW6XI[Mi=P12e(NJoBbnQ/0^7O*[Rb/Ywn;4c]TgN8vA2pSoDIDq7xr6<>N8j3:<6J+%;AjLcQ-d`a/v;PQE7S$5ejS:;ku?l]SWH*dfqxS2TA9o_-CbYBX%>Z+18eRj'u]j(I@@XhNc5.rsH@=8w4x>]=hx@[5fRbYT+e?^d62%c-(7`7i$Cpt5v<dqsB30Cq#+P15>lQ:dDI8t6D$(ceC#.D.WEZ9l%F[)rXGNX+eA`U>?EmY:?tqO[c[%V[4g#aVoVZ,[d/`#?c`[2,7B'Wm_sv?rB<>GN4[UHi/_beqOq`'C?5aM+g;9V#OJ89#.)+sIZ+J),lXID8KflDb1wiUx1FrN-p15FI:j&H7Psf_40e]g)nbcMJlI)0&lrRhu]Gf?YO/aKnO<=;]('Q$Ko29@h;36BP/ES2ru<W/TauEWJ4B_5c=FJHd1.mxSe'R(0/xW[A5@-([<eIZIUGR<eE7Jwg[jV;bPXh-j<G^+rD-TK9UEN*VTDAL[4Mj[L01],gN'p6&4]0^hpDCOhBJl[V<<ZQif2]F4fMU^D'kIE%#Y^qgiAZQL0A$%</76_GS8cKY(1O>)U.,uIW+<#U2brj7[o=?@iL*7H0INhUs-tUikAlZjbYi<HhRHV)[.tBMU[Bf9kou^lVxhK<l[>w$tFKi&jm>]Y&#Su,2QMZDm:7^J6::sOtr]?#prdf>Lg$Xt-(UrR=N&`AW6g$h&a^gX.KA<R[x8THQY8SN*S,;wmr=%_,;tVr609d^aVF,n]W_0YZ,_nB:K$=q@R'R=->W?ad5f;vA8Gvq5cqFd:nZ`Y$P959HmK1$[9_CvuN8K[<jIN]UJ5$Zd9[c]kCjaI3WoUf?01e+C@27E[m+1pt<K&&rKXSxmReE9Z,&b7rYNI?UE<t`?WKWn;Anf@>Vi@eDnJS17NG[LX`9r7gPs98dHI^>o:m>WeBT6juvWGYuh7c:Q%+lQuqT=)c&],?Y.;1U&S7s;@x;ZnIPC>,L2f78SOb3]<p*rmBke^IukEc@Ee]Bwb`GV$&PFqOt^c4o/NRw#rlE8#U^oGfm?.#vUP=#-17D6GEnr]JaDi0[<m2ml-MUlgpiM-L?_31$u0MTG0o8H0b+/viKK$-k]VaXBpe>gC,@-5J(65^@;iGi-5C>-m7B:NaA*T2]+I'#7u?q;os2+/*hw$k&;:/H-o<0dFGXJ8E2%jn$L:GLhu-<]_r%8N_YSpb(uXD2uuY$LRh5$MYuf&1Er7Y_x[mj1F75JY#u'_D.Lc#icu51co<CwjQNKb1;,ds9QZ^5b&[G7[%I]ZX0?d>iYYPwbi'RA#66,6ZEroL^`1cxB$uY0F.iUUijB?K`H5[3i-Ao#b,4TQN2v7?W$4P^nr$w#+dsVZM@tbT&Y<6%Y*#HgFX7R*,(vcQs1S)a9:*m;O1E.l>;:q&%HADB:US58e4vBogv:E=Wts^_wQkH'(J1u_M#1KK5F)[W^F2@x,isQl6`swn61<PN5,t'=l+*WKEQn)A#;u",
@@ -695,11 +2789,39 @@ INLINE static const unsigned char* mixbox_lut()
 {
   struct mixbox_init_t
   {
-    unsigned char lut[64*64*64*3 + 12675];
-    mixbox_init_t() { decompress((char*)lut, sizeof(lut)); }
+    unsigned char lut[MIXBOX_LUT_SIZE];
+    mixbox_init_t() { decompress((char*)lut, sizeof(lut) - 1); }
   };
 
   static const mixbox_init_t decompressed;
 
   return decompressed.lut;
 }
+
+#endif
+
+// 32x32x32 RGBX table resampled from the 64^3 one, so every tap is a single aligned
+// 32-bit load and the whole table fits in 128 KB instead of 768 KB.
+INLINE static const unsigned char* mixbox_lut32()
+{
+  struct mixbox_lut32_t
+  {
+    alignas(64) unsigned char lut[32*32*32*4];
+    mixbox_lut32_t()
+    {
+      for (int b = 0; b < 32; b++)
+      for (int g = 0; g < 32; g++)
+      for (int r = 0; r < 32; r++)
+      {
+        float c[3];
+        lut_fetch<MIXBOX_LUT_TRILINEAR>(float(r) / 31.0f, float(g) / 31.0f, float(b) / 31.0f, c);
+        unsigned char* const entry = &lut[(r + g*32 + b*32*32) * 4];
+        for (int i = 0; i < 3; i++) { entry[i] = (unsigned char)(clamp01(c[i]) * 255.0f + 0.5f); }
+        entry[3] = 0;
+      }
+    }
+  };
+  static const mixbox_lut32_t resampled;
+  return resampled.lut;
+}
+
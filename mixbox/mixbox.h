@@ -25,6 +25,94 @@
 //
 //      mixbox_latent_to_rgb(z_mix, &r, &g, &b);
 //
+//      // or let mixbox_mix_n do the loop, weights are normalized by their sum
+//      mixbox_latent zs[3];  // z1, z2, z3 as above
+//      float weights[3] = { 0.3f, 0.6f, 0.1f };
+//      mixbox_mix_n(zs, weights, 3, z_mix);
+//
+//      If the weights sum to zero or less (all zero, say) there is nothing
+//      to normalize by and z_mix comes out as the all-zero latent, which
+//      converts to black.
+//
+//   BATCHED MULTI-COLOR MIXING
+//
+//      // mixes k images of n interleaved rgb pixels with per-pixel weights,
+//      // the weight of image i at pixel j lives at weights[i*n + j]
+//      const unsigned char* images[3] = { rgb1, rgb2, rgb3 };
+//      mixbox_mix_n_image(images, weights, 3, n, out_rgb);
+//
+//      As with mixbox_mix_n, a pixel whose weights sum to zero or less
+//      comes out black.
+//
+//   LATENT CACHE
+//
+//      // remembers the latents of recently converted colors, so mixing
+//      // the same few colors over and over skips the LUT lookups
+//      mixbox_latent_cache* cache = mixbox_latent_cache_create(8);  // 2^8 slots
+//      mixbox_cached_lerp(cache, r1, g1, b1, r2, g2, b2, t, &r, &g, &b);
+//      mixbox_latent_cache_stats(cache, &hits, &misses);
+//      mixbox_latent_cache_destroy(cache);
+//
+//      A cache is not thread-safe, give each thread its own.
+//
+//   BATCHED CONVERSION
+//
+//      // rgb holds n interleaved pixels (r0 g0 b0 r1 g1 b1 ...)
+//      // latents holds MIXBOX_LATENT_SIZE planes of n floats each,
+//      // component i of pixel j lives at latents[i*n + j]
+//      float* latents = malloc(MIXBOX_LATENT_SIZE * n * sizeof(float));
+//      mixbox_rgb_to_latent_n(rgb, n, latents);
+//      ...
+//      mixbox_latent_to_rgb_n(latents, n, rgb);
+//
+//   PACKED LATENTS
+//
+//      // 16 bytes per latent instead of 28, for keeping pigment data
+//      // per pixel in memory or on disk
+//      mixbox_packed_latent packed;
+//      mixbox_pack_latent(z, packed);
+//      mixbox_unpack_latent(packed, z);
+//
+//      // or planar latents (as in BATCHED CONVERSION) to an array of packed ones
+//      mixbox_pack_latent_n(latents, n, packed_array);
+//      mixbox_unpack_latent_n(packed_array, n, latents);
+//
+//      Components are 16-bit codes, concentrations over [-0.25, 1.75) in
+//      steps of 2^-15 and residuals over [-0.5, 0.5) in steps of 2^-16,
+//      so a round trip moves a component by at most 1.6e-5. Through
+//      mixbox_latent_to_rgb that is at most 1.5e-4 per channel before
+//      rounding: the 8-bit result is unchanged for the latent of every
+//      rgb color, and a mixed latent can round off by at most 1 (about
+//      0.5% of random two-color mixes). Every ISA packs and unpacks
+//      to the same bits.
+//
+//   CPU DISPATCH
+//
+//      The fastest kernels the cpu supports (scalar, SSE4.1, AVX2 or
+//      AVX-512) are picked on first use. For testing, a path can be
+//      forced with mixbox_set_isa(MIXBOX_ISA_SSE41) or by setting the
+//      MIXBOX_ISA environment variable to scalar, sse4.1, avx2 or avx512.
+//
+//   LUT MODES
+//
+//      mixbox_set_lut_mode(MIXBOX_LUT_TETRAHEDRAL) reads 4 LUT entries
+//      per conversion instead of 8, MIXBOX_LUT_TETRAHEDRAL_32 also swaps
+//      the 768 KB table for a 128 KB 32^3 one. mixbox_lut_mode_error()
+//      reports the CIE76 delta E of 50/50 mixes against the default
+//      trilinear mode, so the trade-off can be checked before use.
+//      Below AVX2 the tetrahedral modes are about break-even with
+//      trilinear, they pay off from AVX2 up; mixbox_bench --filter
+//      rgb_to_latent_n measures them on the machine at hand.
+//
+//   LINEAR FLOAT TRANSFER
+//
+//      The linear float entry points convert through the sRGB transfer
+//      curve with std::pow. mixbox_set_transfer_mode(MIXBOX_TRANSFER_FAST)
+//      swaps it for 4096-step tables with linear interpolation, in both
+//      the single-pixel and the batched (_n) paths. Checked over every
+//      float in [0, 1], linear -> sRGB stays within 2e-5 of the exact
+//      curve and sRGB -> linear within 1e-7, far below 1/255.
+//
 //   PIGMENT COLORS
 //
 //      Cadmium Yellow                    254, 236,   0
@@ -50,6 +138,8 @@
 #ifndef MIXBOX_H_
 #define MIXBOX_H_
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,6 +148,33 @@ extern "C" {
 
 typedef float mixbox_latent[MIXBOX_LATENT_SIZE];
 
+#define MIXBOX_PACKED_LATENT_SIZE 8
+
+typedef unsigned short mixbox_packed_latent[MIXBOX_PACKED_LATENT_SIZE];
+
+typedef enum mixbox_isa
+{
+  MIXBOX_ISA_AUTO = 0,
+  MIXBOX_ISA_SCALAR,
+  MIXBOX_ISA_SSE41,
+  MIXBOX_ISA_AVX2,
+  MIXBOX_ISA_AVX512
+} mixbox_isa;
+
+typedef enum mixbox_lut_mode
+{
+  MIXBOX_LUT_TRILINEAR = 0,   // 64^3 table, 8 taps (reference)
+  MIXBOX_LUT_TETRAHEDRAL,     // 64^3 table, 4 taps
+  MIXBOX_LUT_TETRAHEDRAL_32,  // 32^3 RGBX table, 4 taps
+  MIXBOX_LUT_MODE_COUNT
+} mixbox_lut_mode;
+
+typedef enum mixbox_transfer_mode
+{
+  MIXBOX_TRANSFER_EXACT = 0,
+  MIXBOX_TRANSFER_FAST
+} mixbox_transfer_mode;
+
 void mixbox_lerp(unsigned char r1, unsigned char g1, unsigned char b1,
                  unsigned char r2, unsigned char g2, unsigned char b2,
                  float t,
@@ -82,6 +199,50 @@ void mixbox_latent_to_float_rgb(mixbox_latent latent, float* out_r, float* out_g
 void mixbox_linear_float_rgb_to_latent(float r, float g, float b, mixbox_latent out_latent);
 void mixbox_latent_to_linear_float_rgb(mixbox_latent latent, float* out_r, float* out_g, float* out_b);
 
+typedef struct mixbox_latent_cache mixbox_latent_cache;
+
+mixbox_latent_cache* mixbox_latent_cache_create(int capacity_log2);
+void mixbox_latent_cache_destroy(mixbox_latent_cache* cache);
+void mixbox_latent_cache_clear(mixbox_latent_cache* cache);
+void mixbox_latent_cache_stats(const mixbox_latent_cache* cache, unsigned long long* out_hits, unsigned long long* out_misses);
+
+void mixbox_cached_rgb_to_latent(mixbox_latent_cache* cache, unsigned char r, unsigned char g, unsigned char b, mixbox_latent out_latent);
+void mixbox_cached_lerp(mixbox_latent_cache* cache,
+                        unsigned char r1, unsigned char g1, unsigned char b1,
+                        unsigned char r2, unsigned char g2, unsigned char b2,
+                        float t,
+                        unsigned char* out_r, unsigned char* out_g, unsigned char* out_b);
+
+void mixbox_mix_n(const mixbox_latent* inputs, const float* weights, int n, mixbox_latent out_latent);
+void mixbox_mix_n_image(const unsigned char* const* images, const float* weights, int k, size_t n, unsigned char* out_rgb);
+
+void mixbox_rgb_to_latent_n(const unsigned char* rgb, size_t n, float* latents_soa);
+void mixbox_latent_to_rgb_n(const float* latents_soa, size_t n, unsigned char* rgb);
+
+void mixbox_float_rgb_to_latent_n(const float* rgb, size_t n, float* latents_soa);
+void mixbox_latent_to_float_rgb_n(const float* latents_soa, size_t n, float* rgb);
+
+void mixbox_linear_float_rgb_to_latent_n(const float* rgb, size_t n, float* latents_soa);
+void mixbox_latent_to_linear_float_rgb_n(const float* latents_soa, size_t n, float* rgb);
+
+void mixbox_pack_latent(mixbox_latent latent, mixbox_packed_latent out_packed);
+void mixbox_unpack_latent(const mixbox_packed_latent packed, mixbox_latent out_latent);
+
+void mixbox_pack_latent_n(const float* latents_soa, size_t n, mixbox_packed_latent* out_packed);
+void mixbox_unpack_latent_n(const mixbox_packed_latent* packed, size_t n, float* latents_soa);
+
+int mixbox_set_isa(mixbox_isa isa);     // returns 0 if the cpu lacks the requested path
+int mixbox_isa_supported(mixbox_isa isa);
+mixbox_isa mixbox_get_isa(void);
+const char* mixbox_isa_name(mixbox_isa isa);
+
+void mixbox_set_lut_mode(mixbox_lut_mode mode);
+mixbox_lut_mode mixbox_get_lut_mode(void);
+void mixbox_lut_mode_error(mixbox_lut_mode mode, float* out_max_delta_e, float* out_mean_delta_e);
+
+void mixbox_set_transfer_mode(mixbox_transfer_mode mode);
+mixbox_transfer_mode mixbox_get_transfer_mode(void);
+
 #ifdef __cplusplus
 }
 #endif
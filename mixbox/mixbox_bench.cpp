@@ -0,0 +1,299 @@
+// Microbenchmarks for the mixbox conversion, mixing and packing paths, run for every
+// ISA the cpu supports and every LUT mode. Prints one tab-separated record per result,
+//
+//   bench  isa  lut_mode  input  value  unit
+//
+// so runs can be diffed or collected from build to build. "seq" inputs walk an rgb
+// gradient in raster order and stay within a few LUT cells, "rand" inputs are uniform
+// over the rgb cube and miss the caches on most LUT reads. Build with optimizations.
+//
+//   usage: mixbox_bench [--filter <substring>] [--min-time <ms>]
+
+#include "mixbox.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+static const int mixbox_bench_single_count = 1 << 16;
+static const size_t mixbox_bench_batch_count = size_t(1) << 18;
+
+static volatile unsigned int mixbox_bench_sink;
+
+// Stores a value derived from each result, so the optimizer cannot drop the work.
+static void consume(unsigned int value)
+{
+  mixbox_bench_sink = value;
+}
+
+static const char* mixbox_bench_filter = nullptr;
+static double mixbox_bench_min_time_ms = 100.0;
+
+static const char* lut_mode_name(mixbox_lut_mode mode)
+{
+  switch (mode)
+  {
+    case MIXBOX_LUT_TRILINEAR:      return "trilinear";
+    case MIXBOX_LUT_TETRAHEDRAL:    return "tetrahedral";
+    case MIXBOX_LUT_TETRAHEDRAL_32: return "tetrahedral_32";
+    default:                        return "unknown";
+  }
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Repeats body until the calibrated batch runs for at least a fifth of the minimum time,
+// then reports the fastest of five batches so one descheduled batch does not skew a record.
+template<typename Body>
+static double best_ms_per_call(Body body)
+{
+  body();
+
+  long calls = 1;
+  for (;;)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < calls; i++) { body(); }
+    if (elapsed_ms(start) >= mixbox_bench_min_time_ms / 5.0) break;
+    calls *= 2;
+  }
+
+  double best = 1e300;
+  for (int run = 0; run < 5; run++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < calls; i++) { body(); }
+    const double ms = elapsed_ms(start) / double(calls);
+    if (ms < best) best = ms;
+  }
+  return best;
+}
+
+static bool selected(const char* bench)
+{
+  return !mixbox_bench_filter || strstr(bench, mixbox_bench_filter);
+}
+
+static void report(const char* bench, mixbox_isa isa, mixbox_lut_mode mode, const char* input, double value, const char* unit)
+{
+  printf("%s\t%s\t%s\t%s\t%.3f\t%s\n", bench, mixbox_isa_name(isa), lut_mode_name(mode), input, value, unit);
+  fflush(stdout);
+}
+
+// Single-pixel calls are reported as ns per call over a whole input array.
+template<typename Body>
+static void bench_single(const char* bench, const char* input, mixbox_isa isa, mixbox_lut_mode mode, Body body)
+{
+  if (!selected(bench)) return;
+  const double ms = best_ms_per_call(body);
+  report(bench, isa, mode, input, ms * 1e6 / mixbox_bench_single_count, "ns/op");
+}
+
+// Batched calls are reported as input megapixels per second.
+template<typename Body>
+static void bench_batch(const char* bench, const char* input, mixbox_isa isa, mixbox_lut_mode mode, Body body)
+{
+  if (!selected(bench)) return;
+  const double ms = best_ms_per_call(body);
+  report(bench, isa, mode, input, double(mixbox_bench_batch_count) / (ms * 1e3), "Mpx/s");
+}
+
+static void fill_seq(unsigned char* rgb, size_t n)
+{
+  for (size_t j = 0; j < n; j++)
+  {
+    rgb[j*3 + 0] = (unsigned char)(j & 255);
+    rgb[j*3 + 1] = (unsigned char)((j >> 8) & 255);
+    rgb[j*3 + 2] = (unsigned char)((j >> 16) * 61 + 128);
+  }
+}
+
+static void fill_rand(unsigned char* rgb, size_t n, unsigned int seed)
+{
+  unsigned int state = seed;
+  for (size_t j = 0; j < n*3; j++)
+  {
+    state = state*1664525u + 1013904223u;
+    rgb[j] = (unsigned char)(state >> 24);
+  }
+}
+
+// The first conversion of the process pays for building the LUT (or only for faulting in
+// the embedded table with MIXBOX_RAW_LUT), switching to tetrahedral_32 for the 32^3 table
+// and switching to the fast transfer for its tables. Each is timed exactly once.
+static void bench_cold_start(mixbox_isa isa)
+{
+  mixbox_latent latent;
+
+  auto start = std::chrono::steady_clock::now();
+  mixbox_rgb_to_latent(12, 34, 56, latent);
+  const double lut_ms = elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  mixbox_set_lut_mode(MIXBOX_LUT_TETRAHEDRAL_32);
+  mixbox_rgb_to_latent(12, 34, 56, latent);
+  const double lut32_ms = elapsed_ms(start);
+  mixbox_set_lut_mode(MIXBOX_LUT_TRILINEAR);
+
+  start = std::chrono::steady_clock::now();
+  mixbox_set_transfer_mode(MIXBOX_TRANSFER_FAST);
+  const double transfer_ms = elapsed_ms(start);
+  mixbox_set_transfer_mode(MIXBOX_TRANSFER_EXACT);
+
+  consume((unsigned int)(latent[0] * 255.0f));
+
+  if (selected("cold_start"))
+  {
+    report("cold_start_lut", isa, MIXBOX_LUT_TRILINEAR, "-", lut_ms, "ms");
+    report("cold_start_lut32", isa, MIXBOX_LUT_TETRAHEDRAL_32, "-", lut32_ms, "ms");
+    report("cold_start_transfer", isa, MIXBOX_LUT_TRILINEAR, "-", transfer_ms, "ms");
+  }
+}
+
+static void bench_isa_mode(mixbox_isa isa, mixbox_lut_mode mode)
+{
+  const int count = mixbox_bench_single_count;
+  const size_t n = mixbox_bench_batch_count;
+
+  std::vector<unsigned char> inputs[2] = { std::vector<unsigned char>(n*3), std::vector<unsigned char>(n*3) };
+  fill_seq(inputs[0].data(), n);
+  fill_rand(inputs[1].data(), n, 1);
+  const char* const input_names[2] = { "seq", "rand" };
+
+  std::vector<unsigned char> rgb2(n*3);
+  fill_rand(rgb2.data(), n, 2);
+
+  std::vector<mixbox_latent> latents(count);
+  std::vector<float> latents_soa(size_t(MIXBOX_LATENT_SIZE)*n);
+  std::vector<float> float_rgb(n*3);
+  std::vector<unsigned char> out_rgb(n*3);
+  std::vector<mixbox_packed_latent> packed(n);
+
+  for (int in = 0; in < 2; in++)
+  {
+    const unsigned char* const rgb = inputs[in].data();
+    const char* const input = input_names[in];
+
+    bench_single("rgb_to_latent", input, isa, mode, [&]()
+    {
+      for (int j = 0; j < count; j++) { mixbox_rgb_to_latent(rgb[j*3 + 0], rgb[j*3 + 1], rgb[j*3 + 2], latents[j]); }
+      consume((unsigned int)(latents[count - 1][0] * 255.0f));
+    });
+
+    for (int j = 0; j < count; j++) { mixbox_rgb_to_latent(rgb[j*3 + 0], rgb[j*3 + 1], rgb[j*3 + 2], latents[j]); }
+    bench_single("latent_to_rgb", input, isa, mode, [&]()
+    {
+      for (int j = 0; j < count; j++) { mixbox_latent_to_rgb(latents[j], &out_rgb[j*3 + 0], &out_rgb[j*3 + 1], &out_rgb[j*3 + 2]); }
+      consume(out_rgb[0]);
+    });
+
+    bench_single("lerp", input, isa, mode, [&]()
+    {
+      for (int j = 0; j < count; j++)
+      {
+        mixbox_lerp(rgb[j*3 + 0], rgb[j*3 + 1], rgb[j*3 + 2], rgb2[j*3 + 0], rgb2[j*3 + 1], rgb2[j*3 + 2], 0.5f,
+                    &out_rgb[j*3 + 0], &out_rgb[j*3 + 1], &out_rgb[j*3 + 2]);
+      }
+      consume(out_rgb[0]);
+    });
+
+    bench_batch("rgb_to_latent_n", input, isa, mode, [&]()
+    {
+      mixbox_rgb_to_latent_n(rgb, n, latents_soa.data());
+      consume((unsigned int)(latents_soa[0] * 255.0f));
+    });
+
+    mixbox_rgb_to_latent_n(rgb, n, latents_soa.data());
+    bench_batch("latent_to_rgb_n", input, isa, mode, [&]()
+    {
+      mixbox_latent_to_rgb_n(latents_soa.data(), n, out_rgb.data());
+      consume(out_rgb[0]);
+    });
+
+    for (size_t j = 0; j < n*3; j++) { float_rgb[j] = float(rgb[j]) / 255.0f; }
+    bench_batch("float_rgb_to_latent_n", input, isa, mode, [&]()
+    {
+      mixbox_float_rgb_to_latent_n(float_rgb.data(), n, latents_soa.data());
+      consume((unsigned int)(latents_soa[0] * 255.0f));
+    });
+
+    const mixbox_transfer_mode transfers[2] = { MIXBOX_TRANSFER_EXACT, MIXBOX_TRANSFER_FAST };
+    const char* const transfer_names[2] = { "linear_float_rgb_to_latent_n", "linear_float_rgb_to_latent_n_fast" };
+    for (int t = 0; t < 2; t++)
+    {
+      mixbox_set_transfer_mode(transfers[t]);
+      bench_batch(transfer_names[t], input, isa, mode, [&]()
+      {
+        mixbox_linear_float_rgb_to_latent_n(float_rgb.data(), n, latents_soa.data());
+        consume((unsigned int)(latents_soa[0] * 255.0f));
+      });
+    }
+    mixbox_set_transfer_mode(MIXBOX_TRANSFER_EXACT);
+
+    const unsigned char* const images[3] = { rgb, rgb2.data(), inputs[1 - in].data() };
+    std::vector<float> weights(3*n);
+    for (size_t j = 0; j < 3*n; j++) { weights[j] = float((j*7) % 11 + 1); }
+    bench_batch("mix_n_image_k3", input, isa, mode, [&]()
+    {
+      mixbox_mix_n_image(images, weights.data(), 3, n, out_rgb.data());
+      consume(out_rgb[0]);
+    });
+  }
+
+  // Packing does not touch the LUT, so it is only timed once per ISA.
+  if (mode == MIXBOX_LUT_TRILINEAR)
+  {
+    mixbox_rgb_to_latent_n(inputs[1].data(), n, latents_soa.data());
+    bench_batch("pack_latent_n", "rand", isa, mode, [&]()
+    {
+      mixbox_pack_latent_n(latents_soa.data(), n, packed.data());
+      consume(packed[0][0]);
+    });
+    bench_batch("unpack_latent_n", "rand", isa, mode, [&]()
+    {
+      mixbox_unpack_latent_n(packed.data(), n, latents_soa.data());
+      consume((unsigned int)(latents_soa[0] * 255.0f));
+    });
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+    {
+      mixbox_bench_filter = argv[++i];
+    }
+    else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+    {
+      mixbox_bench_min_time_ms = atof(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--filter <substring>] [--min-time <ms>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  printf("bench\tisa\tlut_mode\tinput\tvalue\tunit\n");
+
+  bench_cold_start(mixbox_get_isa());
+
+  const mixbox_isa isas[] = { MIXBOX_ISA_SCALAR, MIXBOX_ISA_SSE41, MIXBOX_ISA_AVX2, MIXBOX_ISA_AVX512 };
+  for (mixbox_isa isa : isas)
+  {
+    if (!mixbox_set_isa(isa)) continue;
+    for (int mode = 0; mode < MIXBOX_LUT_MODE_COUNT; mode++)
+    {
+      mixbox_set_lut_mode(mixbox_lut_mode(mode));
+      bench_isa_mode(isa, mixbox_lut_mode(mode));
+    }
+  }
+  return 0;
+}
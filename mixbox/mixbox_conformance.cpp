@@ -0,0 +1,320 @@
+// Checks every SIMD path against the scalar reference of the same LUT mode: all 2^24
+// rgb inputs through the single-pixel and batched conversions in both directions, and
+// random color pairs and triples through lerp and the K-way mix. Prints one
+// tab-separated record per check with the largest per-channel deviation,
+//
+//   check  isa  lut_mode  max_deviation  tolerance  result
+//
+// and exits with 1 if any deviation is above its tolerance. Latent and float rgb
+// results are held to --tolerance, 8-bit rgb results and packed codes to --tolerance-8bit.
+//
+//   usage: mixbox_conformance [--tolerance <float>] [--tolerance-8bit <int>] [--pairs <count>]
+
+#include "mixbox.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const size_t mixbox_conformance_chunk = size_t(1) << 16;
+
+static double mixbox_conformance_tolerance = 1e-4;
+static int mixbox_conformance_tolerance_8bit = 1;
+static size_t mixbox_conformance_pairs = size_t(1) << 22;
+
+static const char* lut_mode_name(mixbox_lut_mode mode)
+{
+  switch (mode)
+  {
+    case MIXBOX_LUT_TRILINEAR:      return "trilinear";
+    case MIXBOX_LUT_TETRAHEDRAL:    return "tetrahedral";
+    case MIXBOX_LUT_TETRAHEDRAL_32: return "tetrahedral_32";
+    default:                        return "unknown";
+  }
+}
+
+static double max_deviation(const float* a, const float* b, size_t count)
+{
+  double deviation = 0.0;
+  for (size_t i = 0; i < count; i++)
+  {
+    const double d = fabs(double(a[i]) - double(b[i]));
+    if (d != d) return INFINITY;
+    if (d > deviation) deviation = d;
+  }
+  return deviation;
+}
+
+template<typename T>
+static double max_deviation_int(const T* a, const T* b, size_t count)
+{
+  int deviation = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    const int d = abs(int(a[i]) - int(b[i]));
+    if (d > deviation) deviation = d;
+  }
+  return double(deviation);
+}
+
+static void fill_rand(unsigned char* rgb, size_t count, unsigned int* state)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    *state = *state*1664525u + 1013904223u;
+    rgb[i] = (unsigned char)(*state >> 24);
+  }
+}
+
+// Largest deviation of each check for one ISA, accumulated over all chunks.
+struct conformance_result
+{
+  const char* check;
+  bool exact_8bit;
+  double deviation;
+};
+
+enum
+{
+  CHECK_RGB_TO_LATENT,
+  CHECK_RGB_TO_LATENT_N,
+  CHECK_FLOAT_RGB_TO_LATENT_N,
+  CHECK_LINEAR_FLOAT_RGB_TO_LATENT_N,
+  CHECK_LINEAR_FLOAT_RGB_TO_LATENT_N_FAST,
+  CHECK_LATENT_TO_RGB,
+  CHECK_LATENT_TO_RGB_N,
+  CHECK_LATENT_TO_FLOAT_RGB_N,
+  CHECK_LATENT_TO_LINEAR_FLOAT_RGB_N_FAST,
+  CHECK_PACK_LATENT_N,
+  CHECK_UNPACK_LATENT_N,
+  CHECK_LERP,
+  CHECK_MIX_N_IMAGE,
+  CHECK_COUNT
+};
+
+static const conformance_result mixbox_conformance_checks[CHECK_COUNT] =
+{
+  { "rgb_to_latent",                       false, 0.0 },
+  { "rgb_to_latent_n",                     false, 0.0 },
+  { "float_rgb_to_latent_n",               false, 0.0 },
+  { "linear_float_rgb_to_latent_n",        false, 0.0 },
+  { "linear_float_rgb_to_latent_n_fast",   false, 0.0 },
+  { "latent_to_rgb",                       true,  0.0 },
+  { "latent_to_rgb_n",                     true,  0.0 },
+  { "latent_to_float_rgb_n",               false, 0.0 },
+  { "latent_to_linear_float_rgb_n_fast",   false, 0.0 },
+  { "pack_latent_n",                       true,  0.0 },
+  { "unpack_latent_n",                     false, 0.0 },
+  { "lerp",                                true,  0.0 },
+  { "mix_n_image",                         true,  0.0 },
+};
+
+// Everything one chunk produces on one ISA, so the reference and the candidate can be
+// compared element by element.
+struct conformance_outputs
+{
+  std::vector<float> latents;
+  std::vector<float> latents_n;
+  std::vector<float> float_latents_n;
+  std::vector<float> linear_latents_n;
+  std::vector<float> linear_latents_n_fast;
+  std::vector<unsigned char> rgb;
+  std::vector<unsigned char> rgb_n;
+  std::vector<float> float_rgb_n;
+  std::vector<float> linear_rgb_n_fast;
+  std::vector<mixbox_packed_latent> packed;
+  std::vector<float> unpacked;
+
+  explicit conformance_outputs(size_t n)
+    : latents(MIXBOX_LATENT_SIZE*n), latents_n(MIXBOX_LATENT_SIZE*n), float_latents_n(MIXBOX_LATENT_SIZE*n),
+      linear_latents_n(MIXBOX_LATENT_SIZE*n), linear_latents_n_fast(MIXBOX_LATENT_SIZE*n),
+      rgb(3*n), rgb_n(3*n), float_rgb_n(3*n), linear_rgb_n_fast(3*n), packed(n), unpacked(MIXBOX_LATENT_SIZE*n)
+  {
+  }
+};
+
+// The latent -> rgb checks decode the reference latents, so a deviation there is the
+// decoder's own and not carried over from the encoder.
+static void run_chunk(const unsigned char* rgb, const float* float_rgb, const float* reference_latents, size_t n, conformance_outputs* out)
+{
+  for (size_t j = 0; j < n; j++)
+  {
+    mixbox_latent latent;
+    mixbox_rgb_to_latent(rgb[j*3 + 0], rgb[j*3 + 1], rgb[j*3 + 2], latent);
+    for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { out->latents[i*n + j] = latent[i]; }
+  }
+  mixbox_rgb_to_latent_n(rgb, n, out->latents_n.data());
+  mixbox_float_rgb_to_latent_n(float_rgb, n, out->float_latents_n.data());
+  mixbox_set_transfer_mode(MIXBOX_TRANSFER_EXACT);
+  mixbox_linear_float_rgb_to_latent_n(float_rgb, n, out->linear_latents_n.data());
+  mixbox_set_transfer_mode(MIXBOX_TRANSFER_FAST);
+  mixbox_linear_float_rgb_to_latent_n(float_rgb, n, out->linear_latents_n_fast.data());
+
+  if (!reference_latents) reference_latents = out->latents_n.data();
+  for (size_t j = 0; j < n; j++)
+  {
+    mixbox_latent latent;
+    for (int i = 0; i < MIXBOX_LATENT_SIZE; i++) { latent[i] = reference_latents[i*n + j]; }
+    mixbox_latent_to_rgb(latent, &out->rgb[j*3 + 0], &out->rgb[j*3 + 1], &out->rgb[j*3 + 2]);
+  }
+  mixbox_latent_to_rgb_n(reference_latents, n, out->rgb_n.data());
+  mixbox_latent_to_float_rgb_n(reference_latents, n, out->float_rgb_n.data());
+  mixbox_latent_to_linear_float_rgb_n(reference_latents, n, out->linear_rgb_n_fast.data());
+  mixbox_set_transfer_mode(MIXBOX_TRANSFER_EXACT);
+
+  mixbox_pack_latent_n(reference_latents, n, out->packed.data());
+  mixbox_unpack_latent_n(out->packed.data(), n, out->unpacked.data());
+}
+
+static void compare_chunk(const conformance_outputs& reference, const conformance_outputs& candidate, size_t n, conformance_result* results)
+{
+  const size_t latents = MIXBOX_LATENT_SIZE*n;
+  const double deviations[] =
+  {
+    max_deviation(reference.latents.data(), candidate.latents.data(), latents),
+    max_deviation(reference.latents_n.data(), candidate.latents_n.data(), latents),
+    max_deviation(reference.float_latents_n.data(), candidate.float_latents_n.data(), latents),
+    max_deviation(reference.linear_latents_n.data(), candidate.linear_latents_n.data(), latents),
+    max_deviation(reference.linear_latents_n_fast.data(), candidate.linear_latents_n_fast.data(), latents),
+    max_deviation_int(reference.rgb.data(), candidate.rgb.data(), 3*n),
+    max_deviation_int(reference.rgb_n.data(), candidate.rgb_n.data(), 3*n),
+    max_deviation(reference.float_rgb_n.data(), candidate.float_rgb_n.data(), 3*n),
+    max_deviation(reference.linear_rgb_n_fast.data(), candidate.linear_rgb_n_fast.data(), 3*n),
+    max_deviation_int(&reference.packed[0][0], &candidate.packed[0][0], MIXBOX_PACKED_LATENT_SIZE*n),
+    max_deviation(reference.unpacked.data(), candidate.unpacked.data(), latents),
+  };
+  for (int c = 0; c < CHECK_LERP; c++)
+  {
+    if (deviations[c] > results[c].deviation) results[c].deviation = deviations[c];
+  }
+}
+
+// Lerps random pairs at random ratios and mixes random triples with random weights,
+// on the given ISA, so the results can be compared against the scalar run.
+static void run_mixes(size_t count, std::vector<unsigned char>* lerp_rgb, std::vector<unsigned char>* mix_rgb)
+{
+  unsigned int state = 12345u;
+  std::vector<unsigned char> pairs(6*count);
+  fill_rand(pairs.data(), pairs.size(), &state);
+
+  lerp_rgb->resize(3*count);
+  for (size_t j = 0; j < count; j++)
+  {
+    state = state*1664525u + 1013904223u;
+    const float t = float(state >> 8) / 16777216.0f;
+    const unsigned char* p = &pairs[j*6];
+    mixbox_lerp(p[0], p[1], p[2], p[3], p[4], p[5], t, &(*lerp_rgb)[j*3 + 0], &(*lerp_rgb)[j*3 + 1], &(*lerp_rgb)[j*3 + 2]);
+  }
+
+  std::vector<unsigned char> images(3*3*count);
+  fill_rand(images.data(), images.size(), &state);
+  std::vector<float> weights(3*count);
+  for (size_t j = 0; j < weights.size(); j++)
+  {
+    state = state*1664525u + 1013904223u;
+    weights[j] = float(state >> 8) / 16777216.0f;
+  }
+  const unsigned char* const inputs[3] = { &images[0], &images[3*count], &images[6*count] };
+  mix_rgb->resize(3*count);
+  mixbox_mix_n_image(inputs, weights.data(), 3, count, mix_rgb->data());
+}
+
+static bool report(conformance_result* results, mixbox_isa isa, mixbox_lut_mode mode)
+{
+  bool passed = true;
+  for (int c = 0; c < CHECK_COUNT; c++)
+  {
+    const double tolerance = results[c].exact_8bit ? double(mixbox_conformance_tolerance_8bit) : mixbox_conformance_tolerance;
+    const bool ok = results[c].deviation <= tolerance;
+    printf("%s\t%s\t%s\t%.3g\t%.3g\t%s\n", results[c].check, mixbox_isa_name(isa), lut_mode_name(mode), results[c].deviation, tolerance, ok ? "pass" : "FAIL");
+    passed = passed && ok;
+  }
+  fflush(stdout);
+  return passed;
+}
+
+int main(int argc, char* argv[])
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+    {
+      mixbox_conformance_tolerance = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--tolerance-8bit") == 0 && i + 1 < argc)
+    {
+      mixbox_conformance_tolerance_8bit = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--pairs") == 0 && i + 1 < argc)
+    {
+      mixbox_conformance_pairs = size_t(strtoull(argv[++i], nullptr, 10));
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--tolerance <float>] [--tolerance-8bit <int>] [--pairs <count>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<mixbox_isa> isas;
+  const mixbox_isa candidates[] = { MIXBOX_ISA_SSE41, MIXBOX_ISA_AVX2, MIXBOX_ISA_AVX512 };
+  for (mixbox_isa isa : candidates)
+  {
+    if (mixbox_isa_supported(isa)) isas.push_back(isa);
+    else fprintf(stderr, "mixbox_conformance: %s not supported by this cpu, skipped\n", mixbox_isa_name(isa));
+  }
+
+  printf("check\tisa\tlut_mode\tmax_deviation\ttolerance\tresult\n");
+
+  bool passed = true;
+  const size_t n = mixbox_conformance_chunk;
+  std::vector<unsigned char> rgb(3*n);
+  std::vector<float> float_rgb(3*n);
+  conformance_outputs reference(n);
+  conformance_outputs candidate(n);
+
+  for (int m = 0; m < MIXBOX_LUT_MODE_COUNT; m++)
+  {
+    const mixbox_lut_mode mode = mixbox_lut_mode(m);
+    mixbox_set_lut_mode(mode);
+
+    std::vector<std::vector<conformance_result>> results(isas.size(), std::vector<conformance_result>(mixbox_conformance_checks, mixbox_conformance_checks + CHECK_COUNT));
+
+    for (size_t first = 0; first < (size_t(1) << 24); first += n)
+    {
+      for (size_t j = 0; j < n; j++)
+      {
+        const size_t color = first + j;
+        rgb[j*3 + 0] = (unsigned char)(color >> 16);
+        rgb[j*3 + 1] = (unsigned char)(color >> 8);
+        rgb[j*3 + 2] = (unsigned char)(color);
+      }
+      for (size_t j = 0; j < 3*n; j++) { float_rgb[j] = float(rgb[j]) / 255.0f; }
+
+      mixbox_set_isa(MIXBOX_ISA_SCALAR);
+      run_chunk(rgb.data(), float_rgb.data(), nullptr, n, &reference);
+      for (size_t k = 0; k < isas.size(); k++)
+      {
+        mixbox_set_isa(isas[k]);
+        run_chunk(rgb.data(), float_rgb.data(), reference.latents_n.data(), n, &candidate);
+        compare_chunk(reference, candidate, n, results[k].data());
+      }
+    }
+
+    std::vector<unsigned char> reference_lerp, reference_mix, lerp, mix;
+    mixbox_set_isa(MIXBOX_ISA_SCALAR);
+    run_mixes(mixbox_conformance_pairs, &reference_lerp, &reference_mix);
+    for (size_t k = 0; k < isas.size(); k++)
+    {
+      mixbox_set_isa(isas[k]);
+      run_mixes(mixbox_conformance_pairs, &lerp, &mix);
+      results[k][CHECK_LERP].deviation = max_deviation_int(reference_lerp.data(), lerp.data(), lerp.size());
+      results[k][CHECK_MIX_N_IMAGE].deviation = max_deviation_int(reference_mix.data(), mix.data(), mix.size());
+      passed = report(results[k].data(), isas[k], mode) && passed;
+    }
+  }
+
+  return passed ? 0 : 1;
+}
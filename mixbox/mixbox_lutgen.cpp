@@ -0,0 +1,41 @@
+// Decodes the compressed mixbox LUT and writes it out as a C array, so builds with
+// MIXBOX_RAW_LUT can embed the table as read-only data instead of inflating it at runtime.
+//
+//   usage: mixbox_lutgen <output.inc>
+
+#include "mixbox.cpp"
+
+#include <stdio.h>
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <output.inc>\n", argv[0]);
+    return 1;
+  }
+
+  FILE* out = fopen(argv[1], "wb");
+  if (!out)
+  {
+    fprintf(stderr, "mixbox_lutgen: cannot open %s for writing\n", argv[1]);
+    return 1;
+  }
+
+  const unsigned char* lut = mixbox_lut();
+
+  fprintf(out, "// Generated by mixbox_lutgen from mixbox_lut_compressed. Do not edit.\n\n");
+  fprintf(out, "alignas(64) static const unsigned char mixbox_lut_raw[MIXBOX_LUT_SIZE] =\n{\n");
+  for (int i = 0; i < MIXBOX_LUT_SIZE; i++)
+  {
+    fprintf(out, (i % 32 == 0) ? "  %d," : (i % 32 == 31 || i == MIXBOX_LUT_SIZE - 1) ? "%d,\n" : "%d,", lut[i]);
+  }
+  fprintf(out, "};\n");
+
+  if (fclose(out) != 0)
+  {
+    fprintf(stderr, "mixbox_lutgen: failed writing %s\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}